@@ -0,0 +1,115 @@
+/******************************************************************************/
+/*!
+\file   buckets.h
+\brief
+  Unassigned variables filed by domain size - the priority structure
+  behind minimum remaining values ordering.
+  Bucket s is a bitset over variable IDs of the unassigned variables
+  whose domain has s values, so the smallest domain is found by moving
+  a pointer to the lowest non-empty bucket and ties are broken by the
+  lowest ID (the same variable a linear scan would find).
+  Search tells the buckets about assignments and about variables
+  whose domain changed (found in the trail), nothing is scanned per node.
+*/
+/******************************************************************************/
+#ifndef BUCKETS_H
+#define BUCKETS_H
+#include <vector>
+#include "variable.h"
+
+class DomainBuckets {
+	public:
+		////////////////////////////////////////////////////////////
+		DomainBuckets() : 
+			vars(), buckets(), counts(), bucket_of(), min_size(0), unassigned(0) {}
+		////////////////////////////////////////////////////////////
+		//file all unassigned variables (indexed by ID)
+		void Init(const std::vector<Variable*>& all_vars) {
+			vars = all_vars;
+			buckets.clear();
+			counts.clear();
+			bucket_of.assign( vars.size(), -1 );
+			min_size = 0;
+			unassigned = 0;
+			std::vector<Variable*>::const_iterator b_vars = vars.begin();
+			std::vector<Variable*>::const_iterator e_vars = vars.end();
+			for ( ;b_vars!=e_vars;++b_vars) { 
+				if ( ! (*b_vars)->IsAssigned() ) Insert( *b_vars );
+			}
+		}
+		////////////////////////////////////////////////////////////
+		//number of unassigned variables
+		unsigned NumUnassigned() const { return unassigned; }
+		////////////////////////////////////////////////////////////
+		//variable got unassigned
+		void Insert(Variable* var) {
+			unsigned id = var->ID();
+			unsigned size = var->SizeDomain();
+			if ( size >= buckets.size() ) {
+				buckets.resize( size+1, 
+						std::vector<Word>( vars.size()/IntDomain::BITS + 1, 0 ) );
+				counts.resize( size+1, 0 );
+			}
+			buckets[size][id/IntDomain::BITS] |= Word(1) << (id%IntDomain::BITS);
+			++counts[size];
+			bucket_of[id] = size;
+			if ( size < min_size ) min_size = size;
+			++unassigned;
+		}
+		////////////////////////////////////////////////////////////
+		//variable got assigned
+		void Remove(Variable* var) {
+			unsigned id = var->ID();
+			unsigned size = bucket_of[id];
+			buckets[size][id/IntDomain::BITS] &= ~( Word(1) << (id%IntDomain::BITS) );
+			--counts[size];
+			bucket_of[id] = -1;
+			--unassigned;
+		}
+		////////////////////////////////////////////////////////////
+		//domain of the variable changed, ignored for assigned variables
+		void Update(Variable* var) {
+			int size = bucket_of[ var->ID() ];
+			if ( size < 0 || size == var->SizeDomain() ) return;
+			Remove( var );
+			Insert( var );
+		}
+		////////////////////////////////////////////////////////////
+		//all unassigned variables with the smallest domain, 
+		//ordered by ID (appended to "result")
+		void GetMin(std::vector<Variable*>& result) {
+			if ( unassigned == 0 ) return;
+			while ( counts[min_size] == 0 ) ++min_size;
+			const std::vector<Word>& bucket = buckets[min_size];
+			for ( unsigned w=0; w<bucket.size(); ++w ) {
+				for ( Word rest = bucket[w]; rest; rest &= rest-1 ) {
+					result.push_back( vars[ w*IntDomain::BITS + IntDomain::LowestBit(rest) ] );
+				}
+			}
+		}
+		////////////////////////////////////////////////////////////
+		//unassigned variable with the smallest domain (lowest ID 
+		//among ties), 0 if all variables are assigned
+		Variable* Min() {
+			if ( unassigned == 0 ) return 0;
+			while ( counts[min_size] == 0 ) ++min_size;
+			const std::vector<Word>& bucket = buckets[min_size];
+			unsigned w = 0;
+			while ( bucket[w] == 0 ) ++w;
+			return vars[ w*IntDomain::BITS + IntDomain::LowestBit(bucket[w]) ];
+		}
+	private:
+		typedef IntDomain::Word Word;
+		std::vector<Variable*> vars;
+		//bitset of IDs for each domain size
+		std::vector< std::vector<Word> > buckets;
+		//number of variables in each bucket
+		std::vector<unsigned> counts;
+		//current bucket of each variable, -1 if assigned
+		std::vector<int> bucket_of;
+		//all buckets below are empty
+		unsigned min_size;
+		unsigned unassigned;
+};
+
+#endif
@@ -51,6 +51,58 @@
 #include "contraints.h"
 
 
+//read-only view of a contiguous run of IDs owned by ConstraintGraph,
+//returned by retrieval methods. Dereferencing gives the object with
+//that ID (looked up in "table" - variables or constraints of the graph)
+template <typename T>
+class Range {
+	public:
+		class const_iterator {
+			public:
+				const_iterator() : p(0), table(0) {}
+				const_iterator(const unsigned* p, const T* table) : p(p), table(table) {}
+				T operator*() const { return table[*p]; }
+				unsigned ID() const { return *p; }
+				const_iterator& operator++() { ++p; return *this; }
+				const_iterator operator++(int) { const_iterator old(*this); ++p; return old; }
+				bool operator==(const const_iterator& rhs) const { return p == rhs.p; }
+				bool operator!=(const const_iterator& rhs) const { return p != rhs.p; }
+			private:
+				const unsigned* p;
+				const T*        table;
+		};
+		Range() : b(0), e(0), table(0) {}
+		Range(const unsigned* b, const unsigned* e, const T* table) : b(b), e(e), table(table) {}
+		const_iterator begin() const { return const_iterator(b,table); }
+		const_iterator end() const { return const_iterator(e,table); }
+		unsigned size() const { return static_cast<unsigned>(e-b); }
+		bool empty() const { return b == e; }
+		T operator[](unsigned i) const { return table[ b[i] ]; }
+		//raw IDs
+		const unsigned* IDs() const { return b; }
+	private:
+		const unsigned* b;
+		const unsigned* e;
+		const T*        table;
+};
+
+//read-only view of the records of one variable in a typed batch
+//(see ConstraintGraph::SetBatching)
+template <typename T>
+class Batch {
+	public:
+		typedef const T* const_iterator;
+		Batch() : b(0), e(0) {}
+		Batch(const T* b, const T* e) : b(b), e(e) {}
+		const_iterator begin() const { return b; }
+		const_iterator end() const { return e; }
+		unsigned size() const { return static_cast<unsigned>(e-b); }
+		bool empty() const { return b == e; }
+	private:
+		const T* b;
+		const T* e;
+};
+
 //constraint graph - used in CSP Problem
 //just a data structure to simplify access to constraints from variables
 //and vice versa
@@ -60,6 +112,22 @@ class ConstraintGraph {
 		//typedef's
 		typedef T Constraint;
 		typedef typename Constraint::Variable Variable;
+		typedef Range<Variable*> VariableRange;
+		typedef Range<const Constraint*> ConstraintRange;
+		//batched binary constraints of a variable x: x != other
+		//(AllDiff2) and |x-other| != constant (DifferenceNotEqual), 
+		//"id" is the constraint
+		struct NotEqual {
+			Variable* other;
+			unsigned  id;
+		};
+		struct DiffNotEqual {
+			Variable* other;
+			typename Variable::Value constant;
+			unsigned  id;
+		};
+		typedef Batch<NotEqual>     NotEqualBatch;
+		typedef Batch<DiffNotEqual> DiffNotEqualBatch;
 
 		//ctors,dtors
 		ConstraintGraph();
@@ -72,30 +140,117 @@ class ConstraintGraph {
 		void InsertConstraint( const Constraint & c );
 
 		////////////////////////////////////////////////////////////
-		//pre-build collections
+		//pre-build collections - freezes the graph into the compressed
+		//arrays below, retrieval methods are valid only after this call
+		//(call it again if variables/constraints are inserted later).
+		//With SetCliqueFusion first cliques of AllDiff2 constraints are
+		//replaced by AllDiff, which renumbers constraints
 		void PreProcess();
+		////////////////////////////////////////////////////////////
+		//turn the clique fusion in PreProcess on/off (default off - 
+		//fewer constraints, but the AllDiff (VALUES) prunes no more
+		//than its AllDiff2 and is slower to check and revise)
+		void SetCliqueFusion( bool on ) { fuse_cliques = on; }
+		////////////////////////////////////////////////////////////
+		//devirtualized storage (default off): PreProcess also copies
+		//AllDiff2 and DifferenceNotEqual into contiguous arrays of plain
+		//records per variable, so solvers check them in non-virtual
+		//loops, and keeps the constraints of other types apart
+		//(AllDiff2 are left binary only with SetCliqueFusion(false))
+		void SetBatching( bool on ) { batched = on; }
+		bool IsBatched() const { return batched; }
+		////////////////////////////////////////////////////////////
+		//build neighbors and edges in PreProcess (default on) - their
+		//size grows with the square of the number of variables of a
+		//constraint, so models with a large global constraint (Queens)
+		//turn them off: GetNeighbors is empty and there are no edges
+		//(SolveARC only does forward checking)
+		void SetNeighbors( bool on ) { build_neighbors = on; }
+		////////////////////////////////////////////////////////////
+		//build this (empty) graph as a copy of the preprocessed graph
+		//"other" over "copies" of its variables (copies[i] stands for
+		//the variable with ID i): constraints are cloned onto the
+		//copies, the structure built by PreProcess is shared, not
+		//built again. What search changes (weights, entailment) is
+		//the replica's own, so any number of replicas and "other"
+		//can be searched at the same time (see ParallelSearch).
+		//"other" must outlive its replicas and must not PreProcess
+		//again while they exist
+		void Replicate( const ConstraintGraph& other, const std::vector<Variable*>& copies );
 		
 		//retrieval methods
 		////////////////////////////////////////////////////////////
-		//set of Variables which are connected to a given Variable 
-		//by a constraint 
-		const typename std::set<Variable*>& 
-			GetNeighbors( Variable* p_var );
+		//Variables which are connected to a given Variable 
+		//by a constraint (ordered by ID)
+		VariableRange GetNeighbors( Variable* p_var ) const;
+		////////////////////////////////////////////////////////////
+		//all constraints that use the given variables (the order
+		//changes as constraints are entailed, see Entail)
+		ConstraintRange GetConstraints( Variable* p_var ) const;
+		////////////////////////////////////////////////////////////
+		//constraints of the unassigned variable that are not 
+		//entailed, a prefix of GetConstraints (see Entail)
+		ConstraintRange GetActiveConstraints( Variable* p_var ) const;
+		////////////////////////////////////////////////////////////
+		//constraints of the variable by type (IsBatched only): the 
+		//batches and the constraints not in any of them
+		NotEqualBatch GetNotEqual( Variable* p_var ) const;
+		DiffNotEqualBatch GetDiffNotEqual( Variable* p_var ) const;
+		ConstraintRange GetOtherConstraints( Variable* p_var ) const;
+		////////////////////////////////////////////////////////////
+		//Constraints connecting 2 given Variables
+		//(empty if the variables are not neighbors)
+		ConstraintRange GetConnectingConstraints( Variable* p_var1, Variable* p_var2 ) const;
+		////////////////////////////////////////////////////////////
+		//edges are ordered pairs (x,y) of neighbors, numbered so that
+		//edges of x follow each other in the order of GetNeighbors(x):
+		//the i-th neighbor of x is on edge GetFirstEdge(x)+i
+		unsigned GetFirstEdge( Variable* p_var ) const;
 		////////////////////////////////////////////////////////////
-		//all constraints that use the given variables
-		const typename std::vector<const Constraint*>& 
-			GetConstraints( Variable* p_var ) const;
+		//edge (x,y), NoEdge() if the variables are not neighbors
+		unsigned GetEdge( Variable* p_var1, Variable* p_var2 ) const;
 		////////////////////////////////////////////////////////////
-		//vector of Constraints connecting 2 given Variables
-		const typename std::set<const Constraint*>& 
-			GetConnectingConstraints( Variable* p_var1, Variable* p_var2 );
+		//Constraints connecting the 2 variables of an edge
+		ConstraintRange GetEdgeConstraints( unsigned edge ) const;
+		////////////////////////////////////////////////////////////
+		//edge (x,y): x is the source, y is the target,
+		//(y,x) is the reverse edge
+		Variable* GetEdgeSource( unsigned edge ) const { return vars[ compiled->edge_sources[edge] ]; }
+		Variable* GetEdgeTarget( unsigned edge ) const { return vars[ compiled->neighbor_ids[edge] ]; }
+		unsigned  GetReverseEdge( unsigned edge ) const { return compiled->reverse_edges[edge]; }
+		////////////////////////////////////////////////////////////
+		unsigned NumEdges() const { return compiled->neighbor_ids.size(); }
+		////////////////////////////////////////////////////////////
+		//conflict weights of constraints (by Constraint::ID()) used by
+		//dom/wdeg ordering, initially 1, incremented by the solver each
+		//time the constraint wipes out a domain
+		unsigned GetWeight( unsigned constraint_id ) const { return weights[constraint_id]; }
+		void IncrementWeight( unsigned constraint_id ) { ++weights[constraint_id]; }
+		static unsigned NoEdge() { return ~0u; }
 		////////////////////////////////////////////////////////////
 		//vector of all Variables
 		const typename std::vector<Variable*>& GetAllVariables( ) const;
+		////////////////////////////////////////////////////////////
+		//constraint by Constraint::ID()
+		const Constraint* GetConstraint( unsigned id ) const { return constraints[id]; }
+		Constraint* GetConstraint( unsigned id ) { return constraints[id]; }
+		unsigned NumConstraints() const { return constraints.size(); }
+
+		//reversible entailment - an entailed constraint (it cannot 
+		//fail any more) is swapped behind the active constraints of 
+		//each of its variables. RestoreEntailed(checkpoint) activates
+		//the constraints entailed since NumEntailed() returned the
+		//checkpoint, most recent first. PreProcess activates all
+		////////////////////////////////////////////////////////////
+		void Entail( unsigned constraint_id );
+		bool IsEntailed( unsigned constraint_id ) const { return entailed_flags[constraint_id]; }
+		unsigned NumEntailed() const { return entailed.size(); }
+		void RestoreEntailed( unsigned checkpoint );
 
 		//checks
 		////////////////////////////////////////////////////////////
-		//activate/disactivate constraints
+		//activate/disactivate constraints (Constraint::IsActive), 
+		//a pass over all constraints - search uses Entail instead
 		void CheckActivity();
 		////////////////////////////////////////////////////////////
 		//detect solution (that is -- all variable are assigned)
@@ -105,25 +260,118 @@ class ConstraintGraph {
 		void Print() const;
 		////////////////////////////////////////////////////////////
 	private:
+		//check the variable belongs to the graph, returns its ID
+		unsigned IndexOf( Variable* p_var ) const;
+		//replace cliques of AllDiff2 by AllDiff, part of PreProcess
+		void FuseAllDiff2();
+		//fill the typed batches, part of PreProcess
+		void BuildBatches();
+		//positions of constraints in rows, all active, part of PreProcess
+		void InitEntailment();
+		//exchange two positions of constr_ids (same row)
+		void SwapPositions( unsigned p, unsigned q );
+		//range [ offsets[i], offsets[i+1] ) of "ids"
+		static const unsigned* RowBegin( const std::vector<unsigned>& offsets, 
+				const std::vector<unsigned>& ids, unsigned i ) {
+			return ids.data() + offsets[i];
+		}
+		static const unsigned* RowEnd( const std::vector<unsigned>& offsets, 
+				const std::vector<unsigned>& ids, unsigned i ) {
+			return ids.data() + offsets[i+1];
+		}
+
 		//data-structures to simplify life
+		//all of them are indexed by Variable::ID(), which is the 
+		//position of the variable in "vars"
 
-		//mapping from variable to constraints the variable is used in.
-		//that is constraints that depend on the variable
-		std::map<Variable*,std::vector<const Constraint*> > var2constr;
 		//all variables
 		std::vector<Variable*> vars;
-		//all constraints
-		std::vector<Constraint*> constraints;//mainly for print
-		//mapping from variable x to a set of variables Z
-		//each z in Z is connected to x by a constraint
-		//that is: there is a constraint that uses both variables x and z 
-		std::map<Variable*, std::set<Variable*> > neighbors;
-		//for each pair of variables all constraints that use both of them
-		//used in consistency checking
-		std::map< std::pair<Variable*,Variable*>, 
-			std::set<const Constraint*> > connecting_constraints;
+		//all constraints (indexed by Constraint::ID())
+		std::vector<Constraint*> constraints;
+		//conflict weight of each constraint
+		std::vector<unsigned> weights;
+		//mapping from variable to constraints (IDs) the variable is used in,
+		//filled by InsertConstraint, input for PreProcess
+		std::vector< std::vector<unsigned> > var2constr;
+
+		//structure built by PreProcess - IDs only, so replicas of
+		//the graph share it (read only) with the graph they copy
+		struct EdgeSlot {
+			unsigned x, y; //x is ~0 if empty
+			unsigned edge;
+		};
+		struct Compiled {
+			Compiled();
+			//compressed sparse row layout - row x of a table is
+			//ids[ offsets[x] .. offsets[x+1] )
+			//
+			//constraints that depend on variable x (in the order
+			//of InsertConstraint, see constr_ids below)
+			std::vector<unsigned> constr_offsets;
+			std::vector<unsigned> constr_ids;
+			//variables Z connected to x by a constraint, sorted by ID
+			//that is: there is a constraint that uses both variables x and z 
+			//position e of z in neighbor_ids identifies the edge (x,z)
+			std::vector<unsigned> neighbor_offsets;
+			std::vector<unsigned> neighbor_ids;
+			//for each edge e all constraints that use both of its variables
+			//used in consistency checking
+			std::vector<unsigned> edge_constr_offsets;
+			std::vector<unsigned> edge_constr_ids;
+			//source of each edge and the edge in the opposite direction
+			std::vector<unsigned> edge_sources;
+			std::vector<unsigned> reverse_edges;
+			//open-addressing hash of edges: pair (x,y) -> edge
+			//(power of 2 size, at most half full)
+			std::vector<EdgeSlot> edge_table;
+			unsigned edge_shift; //32 - log2 of the table size
+			//rows of the typed batches (records are in the graph,
+			//they point to its variables) and constraints of other types
+			std::vector<unsigned> not_equal_offsets;
+			std::vector<unsigned> diff_not_equal_offsets;
+			std::vector<unsigned> other_offsets;
+			std::vector<unsigned> other_ids;
+			//the k-th variable of constraint c has index
+			//constr_var_offsets[c]+k in constr_positions
+			std::vector<unsigned> constr_var_offsets;
+		};
+		//own structure, or the one of the replicated graph
+		Compiled* compiled;
+		bool owns_compiled;
+		//Fibonacci hashing of the pair (32 bit unsigned arithmetic)
+		unsigned EdgeHash( unsigned x, unsigned y ) const {
+			unsigned const h = ( ( x * 0x9E3779B9u ) ^ y ) * 0x9E3779B9u;
+			return ( h & 0xFFFFFFFFu ) >> compiled->edge_shift;
+		}
 		//for internal use only
 		std::map<std::string,Variable*> name2vars;
+		bool fuse_cliques;
+		bool build_neighbors;
+		//typed batches (row x as above) and constraints of other types
+		bool batched;
+		std::vector<NotEqual> not_equal;
+		std::vector<DiffNotEqual> diff_not_equal;
+		//search state of the rows of Compiled::constr_ids:
+		//row x of constr_ids holds active constraints up to
+		//active_ends[x], then the entailed ones. Constraint c is at 
+		//position constr_positions[ constr_var_offsets[c]+k ] in the 
+		//row of its k-th variable, constr_slots[p] is that k for the
+		//constraint at position p (so a swap updates both positions)
+		std::vector<unsigned> constr_ids;
+		std::vector<unsigned> active_ends;
+		std::vector<unsigned> constr_slots;
+		std::vector<unsigned> constr_positions;
+		//entailed constraints (IDs) in the order of Entail, their
+		//swaps (index of the variable in the constraint, position it
+		//was swapped from) start at entailed_swaps[ entailed_marks[i] ]
+		struct Swap {
+			unsigned slot;
+			unsigned from;
+		};
+		std::vector<unsigned> entailed;
+		std::vector<unsigned> entailed_marks;
+		std::vector<Swap> entailed_swaps;
+		std::vector<bool> entailed_flags;
 };
 
 //#include "contraints.graph.h"
@@ -136,14 +384,48 @@ class ConstraintGraph {
 	#define INLINE 
 #endif
 
+template <typename T>
+ConstraintGraph<T>::Compiled::Compiled() :
+		constr_offsets(),
+		constr_ids(),
+		neighbor_offsets(),
+		neighbor_ids(),
+		edge_constr_offsets(),
+		edge_constr_ids(),
+		edge_sources(),
+		reverse_edges(),
+		edge_table(),
+		edge_shift(32),
+		not_equal_offsets(),
+		diff_not_equal_offsets(),
+		other_offsets(),
+		other_ids(),
+		constr_var_offsets()
+{
+}
+
 template <typename T>
 ConstraintGraph<T>::ConstraintGraph() :
-		var2constr(),
 		vars(),
 		constraints(),
-		neighbors(),
-		connecting_constraints(),
-		name2vars()
+		weights(),
+		var2constr(),
+		compiled(new Compiled),
+		owns_compiled(true),
+		name2vars(),
+		fuse_cliques(false),
+		build_neighbors(true),
+		batched(false),
+		not_equal(),
+		diff_not_equal(),
+		constr_ids(),
+		active_ends(),
+		constr_slots(),
+		constr_positions(),
+		entailed(),
+		entailed_marks(),
+		entailed_swaps(),
+		entailed_flags()
 {
 }
 
@@ -157,7 +439,7 @@ ConstraintGraph<T>::~ConstraintGraph() {
 	for ( ;b_constr!=e_constr;++b_constr) {
 		delete *b_constr;
 	}
-
+	if ( owns_compiled ) delete compiled;
 }
 ////////////////////////////////////////////////////////////
 //activate/disactivate constraints
@@ -177,53 +459,348 @@ void ConstraintGraph<T>::CheckActivity() {
 //build the above data-structures
 template <typename T>
 void ConstraintGraph<T>::PreProcess() {
-	typename std::vector<Variable*>::const_iterator 
-		b_vars = vars.begin();
-	typename std::vector<Variable*>::const_iterator 
-		e_vars = vars.end();
-	for ( ;b_vars!=e_vars;++b_vars) { 
-		const std::vector<const Constraint*>& 
-			constr = GetConstraints( *b_vars );
+	if ( fuse_cliques ) FuseAllDiff2();
+	//a replica stops sharing the structure it was made with
+	if ( !owns_compiled ) {
+		compiled = new Compiled;
+		owns_compiled = true;
+	}
+	unsigned const num_vars = vars.size();
+	compiled->constr_offsets.assign( 1, 0 );
+	compiled->constr_ids.clear();
+	compiled->neighbor_offsets.assign( 1, 0 );
+	compiled->neighbor_ids.clear();
+	compiled->edge_constr_offsets.assign( 1, 0 );
+	compiled->edge_constr_ids.clear();
+	compiled->edge_sources.clear();
 
-		//for all constraints current variable is used in
-		//find all other variables and put them in the set
-		//set ensures no duplicates
-		std::set<Variable*> neigh;
-		typename std::vector<const Constraint*>::const_iterator 
-			b_constr = constr.begin();
-		typename std::vector<const Constraint*>::const_iterator 
-			e_constr = constr.end();
+	//position of a variable in the neighbors of the current variable
+	//-1 if not a neighbor yet
+	std::vector<int> position( num_vars, -1 );
+	//scratch rows of the current variable
+	std::vector<unsigned> neigh;
+	std::vector< std::vector<unsigned> > connecting;
+
+	for ( unsigned x=0; x<num_vars; ++x ) { 
+		const std::vector<unsigned>& constr = var2constr[x];
+		compiled->constr_ids.insert( compiled->constr_ids.end(), constr.begin(), constr.end() );
+		compiled->constr_offsets.push_back( compiled->constr_ids.size() );
 
+		//for all constraints current variable is used in
+		//find all other variables and put them in the neighbors
+		//"position" ensures no duplicates
+		neigh.clear();
+		std::vector<unsigned>::const_iterator b_constr = constr.begin();
+		std::vector<unsigned>::const_iterator e_constr = build_neighbors ? constr.end() : b_constr;
 		for ( ;b_constr!=e_constr;++b_constr) {
 			typename std::vector< Variable*>::const_iterator 
-				b_vars2 = (*b_constr)->GetVars().begin();
+				b_vars2 = constraints[*b_constr]->GetVars().begin();
 			typename std::vector< Variable*>::const_iterator 
-				e_vars2 = (*b_constr)->GetVars().end();
+				e_vars2 = constraints[*b_constr]->GetVars().end();
 			for ( ;b_vars2!=e_vars2;++b_vars2) {
-				if ( *b_vars2 != *b_vars )//excluding the given variable
+				unsigned y = (*b_vars2)->ID();
+				if ( y != x )//excluding the given variable
 				{
-					neigh.insert(*b_vars2);
+					if ( position[y] == -1 ) {
+						position[y] = neigh.size();
+						neigh.push_back( y );
+						if ( connecting.size() < neigh.size() ) connecting.resize( neigh.size() );
+						connecting[ position[y] ].clear();
+					}
 					//current constraint "connects" 2 variables
-					connecting_constraints[
-						std::make_pair// C++11 does not like it <Variable*,Variable*>
-						(*b_vars,*b_vars2)
-						].insert(*b_constr);
+					std::vector<unsigned>& c = connecting[ position[y] ];
+					if ( c.empty() || c.back() != *b_constr ) c.push_back( *b_constr );
 				}
-
 			}
 		}
-		neighbors[*b_vars] = neigh;
+
+		//order neighbors by ID so that pairs can be found by binary search
+		//and append the row (and its edges) to the compressed arrays
+		std::sort( neigh.begin(), neigh.end() );
+		std::vector<unsigned>::const_iterator b_n = neigh.begin();
+		std::vector<unsigned>::const_iterator e_n = neigh.end();
+		for ( ;b_n!=e_n;++b_n) {
+			const std::vector<unsigned>& c = connecting[ position[*b_n] ];
+			compiled->neighbor_ids.push_back( *b_n );
+			compiled->edge_sources.push_back( x );
+			compiled->edge_constr_ids.insert( compiled->edge_constr_ids.end(), c.begin(), c.end() );
+			compiled->edge_constr_offsets.push_back( compiled->edge_constr_ids.size() );
+		}
+		compiled->neighbor_offsets.push_back( compiled->neighbor_ids.size() );
+		for ( b_n = neigh.begin(); b_n!=e_n; ++b_n) { position[*b_n] = -1; }
 	}			
+
+	//hash all edges
+	unsigned bits = 1;
+	while ( ( 1u << bits ) < 2*compiled->neighbor_ids.size() ) ++bits;
+	compiled->edge_shift = 32 - bits;
+	EdgeSlot const empty = { ~0u, 0, 0 };
+	compiled->edge_table.assign( 1u << bits, empty );
+	unsigned const mask = ( 1u << bits ) - 1;
+	for ( unsigned x=0; x<num_vars; ++x ) { 
+		for ( unsigned e=compiled->neighbor_offsets[x]; e<compiled->neighbor_offsets[x+1]; ++e ) {
+			unsigned const y = compiled->neighbor_ids[e];
+			unsigned slot = EdgeHash( x, y );
+			while ( compiled->edge_table[slot].x != ~0u ) slot = ( slot + 1 ) & mask;
+			compiled->edge_table[slot].x    = x;
+			compiled->edge_table[slot].y    = y;
+			compiled->edge_table[slot].edge = e;
+		}
+	}
+
+	//pair up opposite edges (constraints are symmetric, so (y,x) exists)
+	compiled->reverse_edges.resize( compiled->neighbor_ids.size() );
+	for ( unsigned e=0; e<compiled->neighbor_ids.size(); ++e ) {
+		compiled->reverse_edges[e] = GetEdge( vars[ compiled->neighbor_ids[e] ], vars[ compiled->edge_sources[e] ] );
+	}
+
+	compiled->constr_var_offsets.assign( 1, 0 );
+	for ( unsigned c=0; c<constraints.size(); ++c ) {
+		compiled->constr_var_offsets.push_back( compiled->constr_var_offsets.back() + constraints[c]->GetVars().size() );
+	}
+
+	if ( batched ) BuildBatches();
+	InitEntailment();
 }
 
 ////////////////////////////////////////////////////////////
-//set of Variables which are connected to a given Variable 
+//rows start in the order of the structure. A variable used twice 
+//in a constraint has the constraint twice in its row, k-th 
+//occurrence is the first position not taken yet
+template <typename T>
+void ConstraintGraph<T>::InitEntailment() {
+	constr_ids = compiled->constr_ids;
+	active_ends.assign( compiled->constr_offsets.begin()+1, compiled->constr_offsets.end() );
+	constr_slots.assign( constr_ids.size(), 0 );
+	constr_positions.assign( compiled->constr_var_offsets.back(), ~0u );
+	for ( unsigned x=0; x<vars.size(); ++x ) {
+		for ( unsigned p=compiled->constr_offsets[x]; p<compiled->constr_offsets[x+1]; ++p ) {
+			unsigned const c = constr_ids[p];
+			const std::vector<Variable*>& cv = constraints[c]->GetVars();
+			unsigned k = 0;
+			while ( cv[k]->ID() != x || constr_positions[ compiled->constr_var_offsets[c]+k ] != ~0u ) ++k;
+			constr_positions[ compiled->constr_var_offsets[c]+k ] = p;
+			constr_slots[p] = k;
+		}
+	}
+	entailed.clear();
+	entailed_marks.clear();
+	entailed_swaps.clear();
+	entailed_flags.assign( constraints.size(), false );
+}
+
+////////////////////////////////////////////////////////////
+//in the row of each unassigned variable the constraint swaps places
+//with the last active one. Rows of assigned variables are left alone,
+//they are not read again before search backtracks past the entailment
+//(so ForwardChecking may entail while it iterates the row of the 
+//variable it assigned)
+template <typename T>
+INLINE
+void ConstraintGraph<T>::Entail( unsigned constraint_id ) {
+	assert( ! entailed_flags[constraint_id] );
+	const std::vector<Variable*>& cv = constraints[constraint_id]->GetVars();
+	unsigned const base = compiled->constr_var_offsets[constraint_id];
+	entailed.push_back( constraint_id );
+	entailed_marks.push_back( entailed_swaps.size() );
+	entailed_flags[constraint_id] = true;
+	for ( unsigned k=0; k<cv.size(); ++k ) {
+		if ( cv[k]->IsAssigned() ) continue;
+		unsigned const p = constr_positions[base+k];
+		unsigned const last = --active_ends[ cv[k]->ID() ];
+		SwapPositions( p, last );
+		Swap const swap = { k, p };
+		entailed_swaps.push_back( swap );
+	}
+}
+
+////////////////////////////////////////////////////////////
+//swaps are undone in reverse order, so rows get their order back
+//(the order decides what propagates first)
+template <typename T>
+INLINE
+void ConstraintGraph<T>::RestoreEntailed( unsigned checkpoint ) {
+	while ( entailed.size() > checkpoint ) {
+		unsigned const c = entailed.back();
+		const std::vector<Variable*>& cv = constraints[c]->GetVars();
+		while ( entailed_swaps.size() > entailed_marks.back() ) {
+			const Swap& swap = entailed_swaps.back();
+			unsigned const last = active_ends[ cv[swap.slot]->ID() ]++;
+			SwapPositions( swap.from, last );
+			entailed_swaps.pop_back();
+		}
+		entailed_flags[c] = false;
+		entailed.pop_back();
+		entailed_marks.pop_back();
+	}
+}
+
+////////////////////////////////////////////////////////////
+//constraints at positions p and q of a row trade places
+template <typename T>
+INLINE
+void ConstraintGraph<T>::SwapPositions( unsigned p, unsigned q ) {
+	unsigned const c = constr_ids[p];
+	unsigned const slot = constr_slots[p];
+	constr_ids[p] = constr_ids[q];
+	constr_slots[p] = constr_slots[q];
+	constr_positions[ compiled->constr_var_offsets[ constr_ids[p] ] + constr_slots[p] ] = p;
+	constr_ids[q] = c;
+	constr_slots[q] = slot;
+	constr_positions[ compiled->constr_var_offsets[c] + slot ] = q;
+}
+
+////////////////////////////////////////////////////////////
+//constraints of each variable in the order of GetConstraints go
+//to their batch, a DifferenceNotEqual holds its constant
+template <typename T>
+void ConstraintGraph<T>::BuildBatches() {
+	compiled->not_equal_offsets.assign( 1, 0 );
+	not_equal.clear();
+	compiled->diff_not_equal_offsets.assign( 1, 0 );
+	diff_not_equal.clear();
+	compiled->other_offsets.assign( 1, 0 );
+	compiled->other_ids.clear();
+	for ( unsigned x=0; x<vars.size(); ++x ) { 
+		const unsigned* b_c = RowBegin(compiled->constr_offsets,compiled->constr_ids,x);
+		const unsigned* e_c = RowEnd(compiled->constr_offsets,compiled->constr_ids,x);
+		for ( ; b_c!=e_c; ++b_c ) {
+			const Constraint* c = constraints[*b_c];
+			const std::vector<Variable*>& cv = c->GetVars();
+			Variable* other = cv.size() == 2 ? cv[ cv[0] == vars[x] ? 1 : 0 ] : 0;
+			const DifferenceNotEqual<Variable>* dne = 0;
+			if ( other && other != vars[x] && dynamic_cast< const AllDiff2<Variable>* >( c ) ) {
+				NotEqual const record = { other, *b_c };
+				not_equal.push_back( record );
+			} else if ( other && other != vars[x] && 
+					( dne = dynamic_cast< const DifferenceNotEqual<Variable>* >( c ) ) ) {
+				DiffNotEqual const record = { other, dne->GetConstant(), *b_c };
+				diff_not_equal.push_back( record );
+			} else {
+				compiled->other_ids.push_back( *b_c );
+			}
+		}
+		compiled->not_equal_offsets.push_back( not_equal.size() );
+		compiled->diff_not_equal_offsets.push_back( diff_not_equal.size() );
+		compiled->other_offsets.push_back( compiled->other_ids.size() );
+	}
+}
+
+////////////////////////////////////////////////////////////
+//pairwise AllDiff2 over n variables cost n(n-1)/2 constraints and
+//as many entries in every table above. Cliques are grown greedily:
+//from each AllDiff2 (x,y) not fused yet, the other AllDiff2 neighbors
+//of x (in order of ID) join if they are different from all members.
+//Cliques of 3 or more variables become one AllDiff, their AllDiff2
+//are deleted (cliques may overlap, an AllDiff2 in several of them is
+//covered by each). The AllDiff takes the place of the first of its
+//AllDiff2 no earlier clique took (the order decides what propagates
+//first), kept constraints keep their order and weights
+template <typename T>
+void ConstraintGraph<T>::FuseAllDiff2() {
+	unsigned const num_vars = vars.size();
+	//AllDiff2 of each variable: (other variable, constraint ID), 
+	//sorted so that adjacency is a binary search
+	std::vector< std::vector< std::pair<unsigned,unsigned> > > diff( num_vars );
+	for ( unsigned c=0; c<constraints.size(); ++c ) {
+		if ( ! dynamic_cast< const AllDiff2<Variable>* >( constraints[c] ) ) continue;
+		unsigned x = constraints[c]->GetVars()[0]->ID();
+		unsigned y = constraints[c]->GetVars()[1]->ID();
+		if ( x == y ) continue;
+		diff[x].push_back( std::make_pair( y, c ) );
+		diff[y].push_back( std::make_pair( x, c ) );
+	}
+	for ( unsigned x=0; x<num_vars; ++x ) std::sort( diff[x].begin(), diff[x].end() );
+
+	std::vector<bool> fused( constraints.size(), false );
+	//AllDiff (index in all_diffs) taking the place of a constraint
+	std::vector<int> anchor( constraints.size(), -1 );
+	std::vector<bool> in_clique( num_vars, false );
+	std::vector<unsigned> clique;
+	std::vector<Constraint*> all_diffs;
+	for ( unsigned x=0; x<num_vars; ++x ) {
+		for ( unsigned i=0; i<diff[x].size(); ++i ) {
+			unsigned y = diff[x][i].first;
+			if ( y < x || fused[ diff[x][i].second ] ) continue;
+			clique.assign( 1, x );
+			clique.push_back( y );
+			for ( unsigned j=0; j<diff[x].size(); ++j ) {
+				unsigned z = diff[x][j].first;
+				if ( z == y || ( j>0 && diff[x][j-1].first == z ) ) continue;
+				bool adjacent = true;
+				for ( unsigned k=1; k<clique.size() && adjacent; ++k ) {
+					typename std::vector< std::pair<unsigned,unsigned> >::const_iterator it =
+						std::lower_bound( diff[z].begin(), diff[z].end(), std::make_pair( clique[k], 0u ) );
+					adjacent = it != diff[z].end() && it->first == clique[k];
+				}
+				if ( adjacent ) clique.push_back( z );
+			}
+			if ( clique.size() < 3 ) continue;
+
+			std::sort( clique.begin(), clique.end() );
+			AllDiff<Variable>* all_diff = new AllDiff<Variable>();
+			for ( unsigned k=0; k<clique.size(); ++k ) {
+				in_clique[ clique[k] ] = true;
+				all_diff->AddVariable( vars[ clique[k] ] );
+			}
+			//the clique grew from an AllDiff2 not fused yet, the first
+			//of those is its anchor - no other clique has it
+			unsigned first = constraints.size();
+			for ( unsigned k=0; k<clique.size(); ++k ) {
+				typename std::vector< std::pair<unsigned,unsigned> >::const_iterator b_d = diff[ clique[k] ].begin();
+				typename std::vector< std::pair<unsigned,unsigned> >::const_iterator e_d = diff[ clique[k] ].end();
+				for ( ; b_d!=e_d; ++b_d ) {
+					if ( in_clique[ b_d->first ] && !fused[ b_d->second ] ) first = std::min( first, b_d->second );
+				}
+			}
+			for ( unsigned k=0; k<clique.size(); ++k ) {
+				typename std::vector< std::pair<unsigned,unsigned> >::const_iterator b_d = diff[ clique[k] ].begin();
+				typename std::vector< std::pair<unsigned,unsigned> >::const_iterator e_d = diff[ clique[k] ].end();
+				for ( ; b_d!=e_d; ++b_d ) {
+					if ( in_clique[ b_d->first ] ) fused[ b_d->second ] = true;
+				}
+			}
+			for ( unsigned k=0; k<clique.size(); ++k ) in_clique[ clique[k] ] = false;
+			assert( anchor[first] < 0 );
+			anchor[first] = all_diffs.size();
+			all_diffs.push_back( all_diff );
+		}
+	}
+	if ( all_diffs.empty() ) return;
+
+	//renumber
+	std::vector<Constraint*> kept;
+	std::vector<unsigned> kept_weights;
+	for ( unsigned c=0; c<constraints.size(); ++c ) {
+		if ( anchor[c] >= 0 ) {
+			kept.push_back( all_diffs[ anchor[c] ] );
+			kept_weights.push_back( 1 );
+		}
+		if ( fused[c] ) { delete constraints[c]; continue; }
+		kept.push_back( constraints[c] );
+		kept_weights.push_back( weights[c] );
+	}
+	constraints.swap( kept );
+	weights.swap( kept_weights );
+	for ( unsigned x=0; x<num_vars; ++x ) var2constr[x].clear();
+	for ( unsigned c=0; c<constraints.size(); ++c ) {
+		constraints[c]->SetID( c );
+		typename std::vector<Variable*>::const_iterator b_vars = constraints[c]->GetVars().begin();
+		typename std::vector<Variable*>::const_iterator e_vars = constraints[c]->GetVars().end();
+		for ( ; b_vars!=e_vars; ++b_vars ) var2constr[ (*b_vars)->ID() ].push_back( c );
+	}
+}
+
+////////////////////////////////////////////////////////////
+//Variables which are connected to a given Variable 
 //by a constraint 
 template <typename T>
 INLINE 
-const typename std::set<typename ConstraintGraph<T>::Variable*>& 
-ConstraintGraph<T>::GetNeighbors( typename ConstraintGraph<T>::Variable* p_var ) {
-	return neighbors[p_var];
+typename ConstraintGraph<T>::VariableRange
+ConstraintGraph<T>::GetNeighbors( typename ConstraintGraph<T>::Variable* p_var ) const {
+	unsigned x = IndexOf(p_var);
+	return VariableRange( RowBegin(compiled->neighbor_offsets,compiled->neighbor_ids,x), 
+			RowEnd(compiled->neighbor_offsets,compiled->neighbor_ids,x), vars.data() );
 }
 ////////////////////////////////////////////////////////////
 //set of unassigned Variables which are connected to a given Variable 
@@ -239,18 +816,50 @@ ConstraintGraph<T>::GetNeighbors( typename ConstraintGraph<T>::Variable* p_var )
 //	return result;
 //}
 ////////////////////////////////////////////////////////////
-//vector of Constraints connecting 2 given Variables
+//Constraints connecting 2 given Variables
 template <typename T>
 INLINE 
-const typename std::set<const typename ConstraintGraph<T>::Constraint*>& 
+typename ConstraintGraph<T>::ConstraintRange
 ConstraintGraph<T>::GetConnectingConstraints( 
 		typename ConstraintGraph<T>::Variable* p_var1, 
-		typename ConstraintGraph<T>::Variable* p_var2 ) 
+		typename ConstraintGraph<T>::Variable* p_var2 ) const
 {
-	return connecting_constraints[
-		std::make_pair// C++11 does not like it  <Variable*,Variable*> 
-            (p_var1,p_var2)
-		];
+	unsigned e = GetEdge( p_var1, p_var2 );
+	if ( e == NoEdge() ) return ConstraintRange();
+	return GetEdgeConstraints( e );
+}
+////////////////////////////////////////////////////////////
+//first edge out of a variable
+template <typename T>
+INLINE 
+unsigned ConstraintGraph<T>::GetFirstEdge( typename ConstraintGraph<T>::Variable* p_var ) const {
+	return compiled->neighbor_offsets[ IndexOf(p_var) ];
+}
+////////////////////////////////////////////////////////////
+//edge (x,y) - hash lookup, linear probing
+template <typename T>
+INLINE 
+unsigned ConstraintGraph<T>::GetEdge( 
+		typename ConstraintGraph<T>::Variable* p_var1, 
+		typename ConstraintGraph<T>::Variable* p_var2 ) const
+{
+	if ( compiled->edge_table.empty() ) return NoEdge();
+	unsigned const x = IndexOf(p_var1), y = IndexOf(p_var2);
+	unsigned const mask = compiled->edge_table.size() - 1;
+	for ( unsigned slot = EdgeHash( x, y ); ; slot = ( slot + 1 ) & mask ) {
+		EdgeSlot const& s = compiled->edge_table[slot];
+		if ( s.x == x && s.y == y ) return s.edge;
+		if ( s.x == ~0u )           return NoEdge();
+	}
+}
+////////////////////////////////////////////////////////////
+//Constraints connecting the 2 variables of an edge
+template <typename T>
+INLINE 
+typename ConstraintGraph<T>::ConstraintRange
+ConstraintGraph<T>::GetEdgeConstraints( unsigned edge ) const {
+	return ConstraintRange( RowBegin(compiled->edge_constr_offsets,compiled->edge_constr_ids,edge), 
+			RowEnd(compiled->edge_constr_offsets,compiled->edge_constr_ids,edge), constraints.data() );
 }
 ////////////////////////////////////////////////////////////
 //detect dead-end
@@ -266,26 +875,28 @@ ConstraintGraph<T>::GetConnectingConstraints(
 //	return true;
 //}
 ////////////////////////////////////////////////////////////
+//variables are numbered in the order of insertion
 template <typename T>
 void ConstraintGraph<T>::InsertVariable( typename ConstraintGraph<T>::Variable& var ) {
 	//Variable* p_var = new Variable(var);
 	Variable* p_var = &var;
 
+	p_var->SetID( vars.size() );
 	vars.push_back( p_var );
 	name2vars[var.Name()] =  p_var;
 
-	var2constr.insert( 
-			std::make_pair// C++11 does not like it <Variable*,std::vector<const Constraint*> >
-			( p_var, std::vector<const Constraint*>()) ); //initially empty 
+	var2constr.push_back( std::vector<unsigned>() ); //initially empty 
 
 	//std::cout << __FILE__ << " " << __LINE__ << " var address " << p_var << std::endl;
 	//std::cout << *p_var << std::endl; 
 	//std::cout << std::endl;
 }
 ////////////////////////////////////////////////////////////
+//constraints are numbered in the order of insertion
 template <typename T>
 void ConstraintGraph<T>::InsertConstraint( const Constraint & c ) {
 	Constraint* p_c = c.clone();
+	p_c->SetID( constraints.size() );
 	//std::cout << "local constraint " << *p_c << std::endl;
 	const std::vector<Variable*> & vars_in_constraint = p_c->GetVars();
 	//check we know all variables
@@ -297,27 +908,120 @@ void ConstraintGraph<T>::InsertConstraint( const Constraint & c ) {
 	//insert constraint as an outgoing to all variables
 	//used in the constraint
 	for ( ;b!=e;++b) {
-		typename std::map<std::string,Variable*>::iterator 
-			it = name2vars.find( (*b)->Name() );
-		if ( it == name2vars.end() ) {
-			std::cout << "unknown variable name " << (*b)->Name() << std::endl;
-			throw "constraint uses unknown variable name";
+		Variable* p_var = *b;
+		if ( p_var->ID() >= vars.size() || vars[ p_var->ID() ] != p_var ) {
+			//not one of ours - look it up by name
+			typename std::map<std::string,Variable*>::iterator 
+				it = name2vars.find( (*b)->Name() );
+			if ( it == name2vars.end() ) {
+				delete p_c;
+				std::cout << "unknown variable name " << (*b)->Name() << std::endl;
+				throw "constraint uses unknown variable name";
+			}
+			p_var = it->second;
 		}
 		//successfully found variable
-		var2constr[ it->second ].push_back ( p_c );
+		var2constr[ p_var->ID() ].push_back ( p_c->ID() );
 	}
 	constraints.push_back( p_c );
+	weights.push_back( 1 );
+}
+////////////////////////////////////////////////////////////
+//constraints keep their IDs, so do the variables (inserted in the
+//order of "other"), so the structure of "other" is valid as it is
+template <typename T>
+void ConstraintGraph<T>::Replicate( const ConstraintGraph& other,
+		const std::vector<Variable*>& copies ) {
+	typename std::vector<Variable*>::const_iterator b_vars = copies.begin();
+	typename std::vector<Variable*>::const_iterator e_vars = copies.end();
+	for ( ; b_vars!=e_vars; ++b_vars ) {
+		InsertVariable( **b_vars );
+	}
+	typename std::vector<Constraint*>::const_iterator b_constr = other.constraints.begin();
+	typename std::vector<Constraint*>::const_iterator e_constr = other.constraints.end();
+	for ( ; b_constr!=e_constr; ++b_constr ) {
+		Constraint* p_c = (*b_constr)->clone();
+		p_c->SetID( constraints.size() );
+		p_c->Rebind( copies );
+		constraints.push_back( p_c );
+	}
+	weights.assign( constraints.size(), 1 );
+	var2constr = other.var2constr;
+	fuse_cliques = false;
+	build_neighbors = other.build_neighbors;
+	batched = other.batched;
+	if ( owns_compiled ) delete compiled;
+	compiled = other.compiled;
+	owns_compiled = false;
+	//batch records point to the copies
+	not_equal = other.not_equal;
+	typename std::vector<NotEqual>::iterator b_ne = not_equal.begin();
+	typename std::vector<NotEqual>::iterator e_ne = not_equal.end();
+	for ( ; b_ne!=e_ne; ++b_ne ) b_ne->other = copies[ b_ne->other->ID() ];
+	diff_not_equal = other.diff_not_equal;
+	typename std::vector<DiffNotEqual>::iterator b_dne = diff_not_equal.begin();
+	typename std::vector<DiffNotEqual>::iterator e_dne = diff_not_equal.end();
+	for ( ; b_dne!=e_dne; ++b_dne ) b_dne->other = copies[ b_dne->other->ID() ];
+	InitEntailment();
 }
 ////////////////////////////////////////////////////////////
 template <typename T>
 INLINE 
-const typename std::vector<const typename ConstraintGraph<T>::Constraint*>& 
+typename ConstraintGraph<T>::ConstraintRange
 ConstraintGraph<T>::GetConstraints( typename ConstraintGraph<T>::Variable* p_var ) const 
 {
-	typename 
-		std::map< Variable*, std::vector<const Constraint*> >::
-		const_iterator it = var2constr.find( p_var );
-	if ( it	!= var2constr.end() ) return it->second;
+	unsigned x = IndexOf(p_var);
+	return ConstraintRange( RowBegin(compiled->constr_offsets,constr_ids,x), 
+			RowEnd(compiled->constr_offsets,constr_ids,x), constraints.data() );
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+INLINE 
+typename ConstraintGraph<T>::ConstraintRange
+ConstraintGraph<T>::GetActiveConstraints( typename ConstraintGraph<T>::Variable* p_var ) const 
+{
+	unsigned x = IndexOf(p_var);
+	return ConstraintRange( RowBegin(compiled->constr_offsets,constr_ids,x), 
+			constr_ids.data() + active_ends[x], constraints.data() );
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+INLINE 
+typename ConstraintGraph<T>::NotEqualBatch 
+ConstraintGraph<T>::GetNotEqual( typename ConstraintGraph<T>::Variable* p_var ) const 
+{
+	unsigned x = IndexOf(p_var);
+	return NotEqualBatch( not_equal.data() + compiled->not_equal_offsets[x], 
+			not_equal.data() + compiled->not_equal_offsets[x+1] );
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+INLINE 
+typename ConstraintGraph<T>::DiffNotEqualBatch 
+ConstraintGraph<T>::GetDiffNotEqual( typename ConstraintGraph<T>::Variable* p_var ) const 
+{
+	unsigned x = IndexOf(p_var);
+	return DiffNotEqualBatch( diff_not_equal.data() + compiled->diff_not_equal_offsets[x], 
+			diff_not_equal.data() + compiled->diff_not_equal_offsets[x+1] );
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+INLINE 
+typename ConstraintGraph<T>::ConstraintRange 
+ConstraintGraph<T>::GetOtherConstraints( typename ConstraintGraph<T>::Variable* p_var ) const 
+{
+	unsigned x = IndexOf(p_var);
+	return ConstraintRange( RowBegin(compiled->other_offsets,compiled->other_ids,x), 
+			RowEnd(compiled->other_offsets,compiled->other_ids,x), constraints.data() );
+}
+////////////////////////////////////////////////////////////
+//check the variable belongs to the graph, returns its ID
+template <typename T>
+INLINE 
+unsigned ConstraintGraph<T>::IndexOf( typename ConstraintGraph<T>::Variable* p_var ) const 
+{
+	unsigned id = p_var->ID();
+	if ( id < vars.size() && vars[id] == p_var ) return id;
 	else throw "cannot find variable in the graph";
 }
 ////////////////////////////////////////////////////////////
@@ -9,17 +9,44 @@ template <typename T>
 class Constraint {
 	public:
 		typedef T Variable;
+		//domain events that wake a propagator up (see Events),
+		//an assignment is also a bounds change and a removal
+		enum Event {
+			ON_FIXED   = 1, //variable assigned or left with one value
+			ON_BOUNDS  = 2, //min or max of the domain changed
+			ON_REMOVED = 4  //any value removed
+		};
 	protected:
 		std::vector<Variable*> vars;
 		bool active; //active <=> non all variables are given values,
                      //when all vars are assigned it does not make sense to check the constraint
+		unsigned id; //dense index in the ConstraintGraph owning the constraint
+		//scratch for the default Propagate, kept to avoid an allocation per call
+		mutable std::vector<typename Variable::Value> inconsistent;
+		////////////////////////////////////////////////////////////
+		//remove the value from the domain if it is there, 
+		//returns false if the domain becomes empty
+		static bool Prune(Variable* var, typename Variable::Value val);
+		////////////////////////////////////////////////////////////
+		//assigned, or a single value left by propagation - either way
+		//propagated as the variable's value (see Events, ON_FIXED)
+		static bool IsFixed(const Variable* var) { return var->IsAssigned() || var->SizeDomain() == 1; }
+		static typename Variable::Value FixedValue(const Variable* var) {
+			return var->IsAssigned() ? var->GetValue() : var->GetMinValue();
+		}
+		////////////////////////////////////////////////////////////
+		//Supports helpers: set bits of all values of the domain,
+		//clear the bit of one value (if the domain knows it)
+		static void SetBits(const typename Variable::Domain& dom, typename Variable::Domain::Word* row);
+		static void ClearBit(const typename Variable::Domain& dom, typename Variable::Value val,
+				typename Variable::Domain::Word* row);
 	public:
 		////////////////////////////////////////////////////////////
 		//ctor, collect pointers to variables involved in the constraint
 		Constraint(Variable* v1, va_list valist);
 		////////////////////////////////////////////////////////////
 		//default ctor
-		Constraint() : vars(),active(true) { }
+		Constraint() : vars(),active(true),id(0),inconsistent() { }
 		////////////////////////////////////////////////////////////
 		//this is a base class, so make destructor virtual
 		virtual ~Constraint() {}
@@ -32,16 +59,65 @@ class Constraint {
 		//only derived class knows how to implement this check
 		virtual bool Satisfiable() const = 0;
 		////////////////////////////////////////////////////////////
+		//remove values of unassigned variables that cannot satisfy the
+		//constraint given assigned variables and the other domains,
+		//returns false if some domain becomes empty (or assigned 
+		//variables violate the constraint).
+		//Default tries each value with Satisfiable, derived classes
+		//prune directly
+		virtual bool Propagate() const;
+		////////////////////////////////////////////////////////////
+		//weakest event on its variables after which Propagate has to 
+		//run again, default - any change
+		virtual unsigned Events() const { return ON_REMOVED; }
+		////////////////////////////////////////////////////////////
+		//cost class, cheaper propagators run first:
+		//0 - binary, 1 - linear in the number of variables, 2 - more
+		virtual unsigned Priority() const { return vars.size() <= 2 ? 0 : 1; }
+		////////////////////////////////////////////////////////////
+		//true if the constraint cannot fail any more, whatever values
+		//the unassigned variables take (search may skip it until it
+		//backtracks), default - all variables assigned and the 
+		//constraint holds
+		virtual bool Entailed() const;
+		////////////////////////////////////////////////////////////
+		//binary constraints only: set bits (Domain::IndexOf) of the 
+		//values of the other variable compatible with vars[i]=val in
+		//"row" (zeroed, as many words as the other domain's Universe).
+		//Default assigns each pair and asks Satisfiable
+		virtual void Supports(unsigned i, typename Variable::Value val, 
+				typename Variable::Domain::Word* row) const;
+		////////////////////////////////////////////////////////////
+		//start/stop watching the variables (constraints caching
+		//something about their domains), default - nothing to watch.
+		//Destructors do not detach - drivers delete the variables
+		//before the graph owning the constraints (see CSP::CSP)
+		virtual void Attach() {}
+		virtual void Detach() {}
+		////////////////////////////////////////////////////////////
 		virtual void Print (std::ostream& os) const = 0;
 		////////////////////////////////////////////////////////////
 		void AddVariable(Variable* new_var) { this->vars.push_back( new_var ); }
 		////////////////////////////////////////////////////////////
+		//replace each variable by by_id[ its ID ] - a copy of the
+		//variable (see ConstraintGraph::Replicate), call before Attach
+		void Rebind(const std::vector<Variable*>& by_id) {
+			for ( unsigned i=0; i<this->vars.size(); ++i ) {
+				this->vars[i] = by_id[ this->vars[i]->ID() ];
+			}
+		}
+		////////////////////////////////////////////////////////////
 		//return reference to vector of variables used in this 
 		//constraint
 		const std::vector<Variable*> & GetVars() const {
 			return this->vars;
 		}
 		////////////////////////////////////////////////////////////
+		//index of the constraint in the graph (0,1,2,...)
+		//assigned by ConstraintGraph::InsertConstraint
+		unsigned ID() const { return id; }
+		void SetID(unsigned new_id) { id = new_id; }
+		////////////////////////////////////////////////////////////
 		//returns true if Constraint is marked as active
 		bool IsActive() const { return active; }
 		////////////////////////////////////////////////////////////
@@ -60,44 +136,169 @@ class Constraint {
 
 //concrete constraint - sum of any number of variables is equal to SUM
 template <typename Variable, int SUM>
-class SumEqual : public Constraint<Variable> {
+class SumEqual : public Constraint<Variable>, public Variable::Observer {
 	private:
+		typedef typename Variable::Value Value;
 		va_list valist; //need this to pass va_list to base class ctor
+		//while attached - bounds of each variable as last seen and 
+		//their sums, kept up to date by Removed, Restored and Changed (also when
+		//the trail restores values on backtrack)
+		std::vector<Value> lo, hi;
+		Value min_sum, max_sum;
+		bool attached;
+		//copy would not be registered with the variables, use clone
+		SumEqual(const SumEqual&);
+		SumEqual& operator=(const SumEqual&);
 	public:
 		////////////////////////////////////////////////////////////
-		SumEqual() : Constraint<Variable>() {}
+		SumEqual() : Constraint<Variable>(), 
+			lo(), hi(), min_sum(0), max_sum(0), attached(false) {}
 		////////////////////////////////////////////////////////////
 		SumEqual(Variable* v1, ...) 
-			: Constraint<Variable>(v1, (va_start(valist, v1), valist ) ) 
+			: Constraint<Variable>(v1, (va_start(valist, v1), valist ) ),
+			lo(), hi(), min_sum(0), max_sum(0), attached(false)
 		{ va_end(valist); }
 		////////////////////////////////////////////////////////////
 		virtual SumEqual<Variable,SUM>* clone () const;
 		////////////////////////////////////////////////////////////
+		//register with the variables and compute the sums, 
+		//Satisfiable is O(1) afterwards
+		void Attach();
+		void Detach();
+		////////////////////////////////////////////////////////////
+		//variable at position "i" changed, move the sums
+		void Removed(Variable* var, unsigned i, Value val);
+		void Restored(Variable* var, unsigned i, Value val);
+		void Changed(Variable* var, unsigned i);
+		////////////////////////////////////////////////////////////
 		virtual bool Satisfiable() const;
 		////////////////////////////////////////////////////////////
+		//bounds: each variable must fit between SUM minus the largest
+		//and SUM minus the smallest sum of the others
+		virtual bool Propagate() const;
+		////////////////////////////////////////////////////////////
+		unsigned Events() const { return Constraint<Variable>::ON_BOUNDS; }
+		////////////////////////////////////////////////////////////
 		void Print (std::ostream& os) const;
 };
 
 //concrete constraint - all variables are different
 template <typename Variable>
-class AllDiff : public Constraint<Variable> {
+class AllDiff : public Constraint<Variable>, public Variable::Observer {
+	public:
+	//strength of Propagate
+	enum Consistency {
+		VALUES, //values of assigned variables are removed from the others
+		BOUNDS, //bounds consistency - Hall intervals of [min,max]
+		GAC     //every value left is in some solution of the constraint
+		        //(matching based, Regin)
+	};
 	private:
+	typedef typename Variable::Value Value;
 	va_list valist; //need this to pass va_list to base class ctor
+	Consistency consistency;
+	//work arrays reused between calls, so the hot path does not 
+	//allocate (Satisfiable and Propagate are const)
+	//Satisfiable: stamp of the last call that saw value seen_base+i
+	mutable std::vector<unsigned> seen;
+	mutable Value seen_base;
+	mutable unsigned seen_stamp;
+	//BOUNDS: bounds of each variable, variables by upper bound and
+	//upper bounds of the Hall intervals of one lower bound
+	mutable std::vector<Value> mins, maxs;
+	mutable std::vector<unsigned> by_max;
+	mutable std::vector<Value> hall;
+	//GAC: values of each variable (offsets/indices value-lo) and
+	//variables of each value, matching (kept as the initial guess
+	//for the next call), BFS state and Tarjan's SCC state
+	mutable std::vector<unsigned> adj_offsets, adj, val_offsets, val_adj;
+	mutable std::vector<Value> match;
+	mutable std::vector<bool> has_match;
+	mutable std::vector<int> val_match;
+	mutable std::vector<unsigned> pred, bfs, visit_stamp;
+	mutable unsigned visit;
+	mutable std::vector<unsigned> index, lowlink, scc, stack;
+	mutable std::vector<bool> on_stack;
+	mutable unsigned next_index, num_scc;
+	//while attached - number of assigned variables with value 
+	//count_base+i (and the first of them plus 1 in holders), values taken
+	//more than once and the value each variable was counted with,
+	//kept up to date by Changed, so Satisfiable is O(1).
+	//VALUES propagates only variables not "propagated" yet - the flag
+	//is cleared when the variable is (un)assigned or its value comes
+	//back to some domain
+	std::vector<unsigned> counts, holders;
+	Value count_base;
+	unsigned conflicts;
+	std::vector<Value> counted;
+	std::vector<bool> is_counted;
+	mutable std::vector<bool> propagated;
+	bool attached;
+
+	bool PropagateValues() const;
+	bool PropagateBounds() const;
+	bool PropagateGAC() const;
+	//GAC helpers: augmenting path from variable x, component of
+	//node v (variables 0..n-1, values n..n+m-1, extra node n+m)
+	bool Augment(unsigned x, Value lo) const;
+	void StrongConnect(unsigned v, unsigned n, Value lo) const;
+	void Successor(unsigned v, unsigned u, unsigned n, Value lo) const;
+	//grow "a" (indexed by value-base) so that it covers val
+	static void Cover(std::vector<unsigned>& a, Value& base, Value val);
+	//copy would not be registered with the variables, use clone
+	AllDiff(const AllDiff&);
+	AllDiff& operator=(const AllDiff&);
 	public:
 	////////////////////////////////////////////////////////////
-	AllDiff() : Constraint<Variable>() { }
+	AllDiff() : Constraint<Variable>(), consistency(VALUES), 
+		seen(), seen_base(0), seen_stamp(0), mins(), maxs(), by_max(), hall(), 
+		adj_offsets(), adj(), val_offsets(), val_adj(), match(), has_match(),
+		val_match(), pred(), bfs(), visit_stamp(), visit(0), 
+		index(), lowlink(), scc(), stack(), on_stack(), next_index(0), num_scc(0),
+		counts(), holders(), count_base(0), conflicts(0), counted(), is_counted(), 
+		propagated(), attached(false) { }
 	////////////////////////////////////////////////////////////
 	AllDiff(Variable* v1, ...) 
-		: Constraint<Variable>(v1, (va_start(valist, v1), valist ) ) 
+		: Constraint<Variable>(v1, (va_start(valist, v1), valist ) ), consistency(VALUES), 
+		seen(), seen_base(0), seen_stamp(0), mins(), maxs(), by_max(), hall(), 
+		adj_offsets(), adj(), val_offsets(), val_adj(), match(), has_match(),
+		val_match(), pred(), bfs(), visit_stamp(), visit(0), 
+		index(), lowlink(), scc(), stack(), on_stack(), next_index(0), num_scc(0),
+		counts(), holders(), count_base(0), conflicts(0), counted(), is_counted(), 
+		propagated(), attached(false)
 	{ va_end(valist); }
 	////////////////////////////////////////////////////////////
 	virtual AllDiff<Variable>* clone () const;
 	////////////////////////////////////////////////////////////
 	void Print (std::ostream& os) const;
 	////////////////////////////////////////////////////////////
+	//choose what Propagate enforces (default VALUES), set before
+	//solving - the scheduler reads Events once
+	void SetConsistency(Consistency c) { consistency = c; }
+	////////////////////////////////////////////////////////////
+	//register with the variables and count assigned values
+	void Attach();
+	void Detach();
+	////////////////////////////////////////////////////////////
+	//variable at position "i" was (un)assigned - move the counts,
+	//a restored value may have to be propagated again
+	void Removed(Variable*, unsigned, Value) {}
+	void Restored(Variable* var, unsigned i, Value val);
+	void Changed(Variable* var, unsigned i);
+	////////////////////////////////////////////////////////////
 	//constraint is true if all currently assigned variables have 
 	//different values
 	bool Satisfiable() const;
+	////////////////////////////////////////////////////////////
+	//see Consistency
+	bool Propagate() const;
+	////////////////////////////////////////////////////////////
+	unsigned Events() const { 
+		return consistency == GAC    ? Constraint<Variable>::ON_REMOVED :
+		       consistency == BOUNDS ? Constraint<Variable>::ON_BOUNDS : 
+		                               Constraint<Variable>::ON_FIXED;
+	}
+	unsigned Priority() const { return 2; }
 };
 
 
@@ -118,6 +319,19 @@ class AllDiff2 : public Constraint<Variable> {
 		//constraint is true if all currently assigned variables have 
 		//different values
 		bool Satisfiable() const;
+		////////////////////////////////////////////////////////////
+		//once one variable is assigned its value is removed from 
+		//the other one
+		bool Propagate() const;
+		////////////////////////////////////////////////////////////
+		//all values of the other variable but val
+		void Supports(unsigned i, typename Variable::Value val, 
+				typename Variable::Domain::Word* row) const;
+		////////////////////////////////////////////////////////////
+		unsigned Events() const { return Constraint<Variable>::ON_FIXED; }
+		////////////////////////////////////////////////////////////
+		//the domains have no common value
+		bool Entailed() const;
 };
 
 //concrete constraint - all variables are different
@@ -134,11 +348,228 @@ class DifferenceNotEqual : public Constraint<Variable> {
 		////////////////////////////////////////////////////////////
 		virtual DifferenceNotEqual<Variable>* clone () const;
 		////////////////////////////////////////////////////////////
+		int GetConstant() const { return constant; }
+		////////////////////////////////////////////////////////////
 		void Print (std::ostream& os) const;
 		////////////////////////////////////////////////////////////
 		//constraint is true if all currently assigned variables have 
 		//different values
 		bool Satisfiable() const;
+		////////////////////////////////////////////////////////////
+		//once one variable is assigned its value plus/minus the
+		//constant is removed from the other one
+		bool Propagate() const;
+		////////////////////////////////////////////////////////////
+		//all values of the other variable but val +/- constant
+		void Supports(unsigned i, typename Variable::Value val, 
+				typename Variable::Domain::Word* row) const;
+		////////////////////////////////////////////////////////////
+		unsigned Events() const { return Constraint<Variable>::ON_FIXED; }
+		////////////////////////////////////////////////////////////
+		//an assigned variable has no value at distance constant in
+		//the other domain
+		bool Entailed() const;
+};
+
+//concrete constraint - values of the variables form one of the 
+//allowed tuples (extensional constraint), propagated by Compact-Table
+template <typename Variable>
+class Table : public Constraint<Variable>, public Variable::Observer {
+	private:
+		typedef typename Variable::Value Value;
+		typedef typename Variable::Domain::Word Word;
+		va_list valist; //need this to pass va_list to base class ctor
+		//allowed tuples, one after another
+		std::vector<Value> tuples;
+		//while attached - values of each variable found in the tuples
+		//(sorted), the mask of values[i][k] (bitset of the tuples with
+		//it) is at masks[ ( mask_offsets[i]+k ) * num_words ], and the 
+		//last word where it met a valid tuple in residues[ mask_offsets[i]+k ]
+		std::vector< std::vector<Value> > values;
+		std::vector<unsigned> mask_offsets;
+		std::vector<Word> masks;
+		unsigned num_words;
+		mutable std::vector<unsigned> residues;
+		//reversible sparse bitset of the tuples valid for the domains 
+		//(assignments are applied on top of it by each call), non-zero
+		//words are words[ index[0..limit-1] ]
+		mutable std::vector<Word> words;
+		mutable std::vector<unsigned> index;
+		mutable unsigned limit;
+		//domain size of each variable when words were last updated and
+		//values removed since then (complete unless reset)
+		mutable std::vector<unsigned> last_size;
+		mutable std::vector< std::vector<Value> > delta;
+		mutable std::vector<bool> reset;
+		//undo - words and sizes changed by an update are saved once per
+		//frame, a frame is popped when the trail takes back a removal
+		//it has seen ("removals" counts removals minus restorations of
+		//the values of the variables, a frame keeps the count it was
+		//opened at)
+		struct Frame {
+			int tag;
+			unsigned num_saved_words, num_saved_sizes, limit;
+			Frame(int tag, unsigned num_saved_words, unsigned num_saved_sizes, unsigned limit) 
+				: tag(tag), num_saved_words(num_saved_words), num_saved_sizes(num_saved_sizes), limit(limit) {}
+		};
+		mutable std::vector<Frame> frames;
+		mutable std::vector< std::pair<unsigned,Word> > saved_words;
+		mutable std::vector< std::pair<unsigned,unsigned> > saved_sizes;
+		mutable std::vector<unsigned> word_frame;
+		mutable unsigned frame_serial;
+		int removals;
+		//assignment of each variable as last seen by Changed
+		std::vector<bool> is_assigned;
+		std::vector<Value> assigned_value;
+		bool attached;
+		//work arrays: masks of the assigned values, tuples valid for
+		//domains and assignments, union of masks (values to remove
+		//go to Constraint::inconsistent)
+		mutable std::vector<const Word*> fixed;
+		mutable std::vector<Word> valid, mask;
+
+		//index of val in values[i], -1 if no tuple has it
+		int Find(unsigned i, Value val) const;
+		const Word* Mask(unsigned i, unsigned k) const { return &masks[ ( mask_offsets[i]+k ) * num_words ]; }
+		//all tuples valid, no frames, all variables to be read again
+		void Rebuild();
+		//masks of assigned values into "fixed", false if some value
+		//is in no tuple
+		bool Fix() const;
+		//remove tuples killed by domain changes since the last update
+		void Update() const;
+		//words &= mask (or ~mask)
+		void Intersect(bool negate) const;
+		void OpenFrame() const;
+		void PopFrame();
+		//copy would not be registered with the variables, use clone
+		Table(const Table&);
+		Table& operator=(const Table&);
+	public:
+		////////////////////////////////////////////////////////////
+		Table() : Constraint<Variable>(), 
+			tuples(), values(), mask_offsets(), masks(), num_words(0), residues(),
+			words(), index(), limit(0), last_size(), delta(), reset(),
+			frames(), saved_words(), saved_sizes(), word_frame(), frame_serial(0), removals(0),
+			is_assigned(), assigned_value(), attached(false), fixed(), valid(), mask() {}
+		////////////////////////////////////////////////////////////
+		Table(Variable* v1, ...) 
+			: Constraint<Variable>(v1, (va_start(valist, v1), valist ) ),
+			tuples(), values(), mask_offsets(), masks(), num_words(0), residues(),
+			words(), index(), limit(0), last_size(), delta(), reset(),
+			frames(), saved_words(), saved_sizes(), word_frame(), frame_serial(0), removals(0),
+			is_assigned(), assigned_value(), attached(false), fixed(), valid(), mask()
+		{ va_end(valist); }
+		////////////////////////////////////////////////////////////
+		virtual Table<Variable>* clone () const;
+		////////////////////////////////////////////////////////////
+		void Print (std::ostream& os) const;
+		////////////////////////////////////////////////////////////
+		//allow a tuple, one value per variable (add the variables
+		//first), before the constraint is attached
+		void AddTuple(const std::vector<Value>& tuple);
+		unsigned NumTuples() const { return this->vars.empty() ? 0 : tuples.size() / this->vars.size(); }
+		////////////////////////////////////////////////////////////
+		//build the masks and register with the variables
+		void Attach();
+		void Detach();
+		////////////////////////////////////////////////////////////
+		//collect removals (delta), restorations pop frames, 
+		//SetDomain starts over
+		void Removed(Variable* var, unsigned i, Value val);
+		void Restored(Variable* var, unsigned i, Value val);
+		void Changed(Variable* var, unsigned i);
+		////////////////////////////////////////////////////////////
+		//some tuple agrees with the assigned variables (and with the 
+		//domains as of the last Propagate)
+		bool Satisfiable() const;
+		////////////////////////////////////////////////////////////
+		//update the valid tuples from the domain changes (removed masks
+		//or the union of the masks left, whichever is smaller), then 
+		//remove values without a valid tuple (GAC)
+		bool Propagate() const;
+		////////////////////////////////////////////////////////////
+		unsigned Priority() const { return 2; }
+};
+
+//concrete constraint - n queens: variable i is the row of the queen
+//in column i (its position in the constraint), no two queens share a
+//row, a diagonal (row+column) or an anti-diagonal (row-column). 
+//Occupancy counters of these lines take the place of the n(n-1) 
+//binary constraints of the pairwise model - O(n+rows) memory
+template <typename Variable>
+class Queens : public Constraint<Variable>, public Variable::Observer {
+	private:
+		typedef typename Variable::Value Value;
+		va_list valist; //need this to pass va_list to base class ctor
+		//queens on row lo+r (rows[r]), on diagonal row+column = lo+d
+		//(diagonals[d]) and on anti-diagonal row-column = lo-(n-1)+a 
+		//(anti_diagonals[a]), rows lo..hi cover the domains, 
+		//"conflicts" counts queens after the first one on each line.
+		//Kept up to date by Changed while attached (Satisfiable is 
+		//O(1)), recounted by each call otherwise
+		mutable std::vector<unsigned> rows, diagonals, anti_diagonals;
+		mutable Value lo, hi;
+		mutable unsigned conflicts;
+		//row each variable was counted with
+		mutable std::vector<Value> counted;
+		mutable std::vector<bool> is_counted;
+		//assigned variables whose lines are not removed from the other
+		//domains yet (each listed once), all assigned variables are
+		//propagated again after a value came back to a line in use
+		mutable std::vector<unsigned> pending;
+		mutable std::vector<bool> is_pending, propagated;
+		mutable bool propagate_all;
+		bool attached;
+
+		//range, counters and pending from the domains and assignments
+		void Recount() const;
+		//put (delta 1) or take away (-1) the queen of column i on row 
+		//val (inside lo..hi)
+		void Count(unsigned i, Value val, int delta) const;
+		void Move(unsigned& counter, int delta) const;
+		//some queen is on a line of (column i, row val)
+		bool Attacked(unsigned i, Value val) const;
+		//copy would not be registered with the variables, use clone
+		Queens(const Queens&);
+		Queens& operator=(const Queens&);
+	public:
+		////////////////////////////////////////////////////////////
+		Queens() : Constraint<Variable>(), 
+			rows(), diagonals(), anti_diagonals(), lo(0), hi(0), conflicts(0), 
+			counted(), is_counted(), pending(), is_pending(), propagated(), 
+			propagate_all(true), attached(false) {}
+		////////////////////////////////////////////////////////////
+		Queens(Variable* v1, ...) 
+			: Constraint<Variable>(v1, (va_start(valist, v1), valist ) ),
+			rows(), diagonals(), anti_diagonals(), lo(0), hi(0), conflicts(0), 
+			counted(), is_counted(), pending(), is_pending(), propagated(), 
+			propagate_all(true), attached(false)
+		{ va_end(valist); }
+		////////////////////////////////////////////////////////////
+		virtual Queens<Variable>* clone () const;
+		////////////////////////////////////////////////////////////
+		void Print (std::ostream& os) const;
+		////////////////////////////////////////////////////////////
+		//count the queens and register with the variables
+		void Attach();
+		void Detach();
+		////////////////////////////////////////////////////////////
+		//variable in column i was (un)assigned - move its queen, a
+		//restored value on an occupied line has to be pruned again
+		void Removed(Variable*, unsigned, Value) {}
+		void Restored(Variable* var, unsigned i, Value val);
+		void Changed(Variable* var, unsigned i);
+		////////////////////////////////////////////////////////////
+		//no two assigned queens attack each other
+		bool Satisfiable() const;
+		////////////////////////////////////////////////////////////
+		//the row and both diagonals of each newly assigned queen, and
+		//of each queen left with one row, are removed from the
+		//unassigned variables
+		bool Propagate() const;
+		////////////////////////////////////////////////////////////
+		unsigned Events() const { return Constraint<Variable>::ON_FIXED; }
 };
 
 #include "contraints.h"
@@ -146,6 +577,7 @@ class DifferenceNotEqual : public Constraint<Variable> {
 #include <cmath>
 #include <cstdlib>
 #include <set>
+#include <algorithm>
 
 #ifdef INLINE_CONSTRAINT
 	//#warning "INFO - inlining Constraint methods"
@@ -158,7 +590,7 @@ class DifferenceNotEqual : public Constraint<Variable> {
 ////////////////////////////////////////////////////////////
 //ctor, collect pointers to variables involved in the constraint
 template <typename T>
-Constraint<T>::Constraint(Variable* v1, va_list valist) : vars(), active(true) {
+Constraint<T>::Constraint(Variable* v1, va_list valist) : vars(), active(true), id(0), inconsistent() {
 	Variable* arg;
 	this->vars.push_back(v1);
 	while ((arg = va_arg(valist, Variable*)) != 0) {
@@ -195,6 +627,96 @@ bool Constraint<T>::Check () const {
 	return Satisfiable();
 }
 
+////////////////////////////////////////////////////////////
+template <typename T>
+INLINE bool Constraint<T>::Entailed() const {
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	for ( ; b!=e; ++b ) {
+		if ( ! (*b)->IsAssigned() ) return false;
+	}
+	return Satisfiable();
+}
+////////////////////////////////////////////////////////////
+//remove the value from the domain if it is there
+template <typename T>
+INLINE bool Constraint<T>::Prune(Variable* var, typename Variable::Value val) {
+	if ( var->GetDomain().Contains(val) ) var->RemoveValue(val);
+	return !var->IsImpossible();
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+INLINE void Constraint<T>::SetBits(const typename Variable::Domain& dom, typename Variable::Domain::Word* row) {
+	if ( dom.Words() ) {
+		std::copy( dom.Words(), dom.Words() + dom.NumWords(), row );
+		return;
+	}
+	typename Variable::Domain::const_iterator b_dom = dom.begin();
+	typename Variable::Domain::const_iterator e_dom = dom.end();
+	for ( ; b_dom!=e_dom; ++b_dom ) {
+		unsigned index = dom.IndexOf(*b_dom);
+		row[ index / Variable::Domain::BITS ] |= 
+			typename Variable::Domain::Word(1) << ( index % Variable::Domain::BITS );
+	}
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+INLINE void Constraint<T>::ClearBit(const typename Variable::Domain& dom, typename Variable::Value val,
+		typename Variable::Domain::Word* row) {
+	int index = dom.IndexOf(val);
+	if ( index < 0 ) return;
+	row[ index / Variable::Domain::BITS ] &= 
+		~( typename Variable::Domain::Word(1) << ( index % Variable::Domain::BITS ) );
+}
+////////////////////////////////////////////////////////////
+//generate and test
+template <typename T>
+void Constraint<T>::Supports(unsigned i, typename Variable::Value val, 
+		typename Variable::Domain::Word* row) const {
+	Variable* x = vars[i];
+	Variable* y = vars[1-i];
+	const typename Variable::Domain& dom = y->GetDomain();
+	x->Assign(val);
+	typename Variable::Domain::const_iterator b_dom = dom.begin();
+	typename Variable::Domain::const_iterator e_dom = dom.end();
+	for ( ; b_dom!=e_dom; ++b_dom ) {
+		y->Assign(*b_dom);
+		if ( Satisfiable() ) {
+			unsigned index = dom.IndexOf(*b_dom);
+			row[ index / Variable::Domain::BITS ] |= 
+				typename Variable::Domain::Word(1) << ( index % Variable::Domain::BITS );
+		}
+		y->UnAssign();
+	}
+	x->UnAssign();
+}
+////////////////////////////////////////////////////////////
+//generate and test - each value of each unassigned variable is
+//assigned and checked with Satisfiable
+template <typename T>
+bool Constraint<T>::Propagate() const {
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	for ( ; b!=e; ++b ) {
+		if ( (*b)->IsAssigned() ) continue;
+		//values are removed after the scan - removal may reorder the domain
+		inconsistent.clear();
+		typename Variable::Domain::const_iterator b_dom = (*b)->GetDomain().begin();
+		typename Variable::Domain::const_iterator e_dom = (*b)->GetDomain().end();
+		for ( ; b_dom!=e_dom; ++b_dom ) {
+			(*b)->Assign(*b_dom);
+			if ( ! Satisfiable() ) inconsistent.push_back(*b_dom);
+			(*b)->UnAssign();
+		}
+		typename std::vector<typename Variable::Value>::const_iterator b_v = inconsistent.begin();
+		typename std::vector<typename Variable::Value>::const_iterator e_v = inconsistent.end();
+		for ( ; b_v!=e_v; ++b_v ) {
+			(*b)->RemoveValue(*b_v);
+		}
+		if ( (*b)->IsImpossible() ) return false;
+	}
+	return Satisfiable();
+}
 ////////////////////////////////////////////////////////////
 template <typename T>
 std::ostream& operator<<(std::ostream& os, const Constraint<T>& c) {
@@ -220,11 +742,67 @@ SumEqual<Variable,SUM>* SumEqual<Variable,SUM>::clone () const
 	return copy;
 }
 ////////////////////////////////////////////////////////////
+template <typename Variable, int SUM>
+void SumEqual<Variable,SUM>::Attach() {
+	if ( attached ) return;
+	lo.resize( this->vars.size() );
+	hi.resize( this->vars.size() );
+	min_sum = max_sum = 0;
+	for ( unsigned i=0; i<this->vars.size(); ++i ) {
+		lo[i] = this->vars[i]->GetMinValue();
+		hi[i] = this->vars[i]->GetMaxValue();
+		min_sum += lo[i];
+		max_sum += hi[i];
+		this->vars[i]->AddObserver( this, i );
+	}
+	attached = true;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable, int SUM>
+void SumEqual<Variable,SUM>::Detach() {
+	if ( !attached ) return;
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	for ( ; b!=e; ++b ) {
+		(*b)->RemoveObserver( this );
+	}
+	attached = false;
+}
+////////////////////////////////////////////////////////////
+//only removal of a bound moves it
+template <typename Variable, int SUM>
+INLINE void SumEqual<Variable,SUM>::Removed(Variable* var, unsigned i, Value val) {
+	if ( var->IsAssigned() || ( val != lo[i] && val != hi[i] ) ) return;
+	Changed( var, i );
+}
+////////////////////////////////////////////////////////////
+//a restored value can only widen the bounds
+template <typename Variable, int SUM>
+INLINE void SumEqual<Variable,SUM>::Restored(Variable* var, unsigned i, Value val) {
+	if ( var->IsAssigned() ) return;
+	if ( val < lo[i] ) { min_sum += val - lo[i]; lo[i] = val; }
+	if ( val > hi[i] ) { max_sum += val - hi[i]; hi[i] = val; }
+}
+////////////////////////////////////////////////////////////
+//an empty domain has no bounds - keep the old ones, the sums are
+//fixed when the trail restores a value
+template <typename Variable, int SUM>
+INLINE void SumEqual<Variable,SUM>::Changed(Variable* var, unsigned i) {
+	if ( !var->IsAssigned() && var->IsImpossible() ) return;
+	Value min = var->GetMinValue();
+	Value max = var->GetMaxValue();
+	min_sum += min - lo[i];
+	max_sum += max - hi[i];
+	lo[i] = min;
+	hi[i] = max;
+}
+////////////////////////////////////////////////////////////
 //keeps track of minimum and maximum assignment of variables
 //in order for the constraint to be satisfiable 
 //the SUM has to be between the 2 quantities above
 template <typename Variable, int SUM>
 INLINE bool SumEqual<Variable,SUM>::Satisfiable() const {
+	if ( attached ) return min_sum <= SUM && max_sum >= SUM;
 	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
 	typename std::vector<Variable*>::const_iterator e = this->vars.end();
 	typename Variable::Value min_sum=0;
@@ -236,6 +814,46 @@ INLINE bool SumEqual<Variable,SUM>::Satisfiable() const {
 	return min_sum <= SUM && max_sum >=SUM;
 }
 ////////////////////////////////////////////////////////////
+//variables are processed in order, bounds of the sums are updated
+//after each variable is pruned (starting from the cached sums if
+//attached)
+template <typename Variable, int SUM>
+INLINE bool SumEqual<Variable,SUM>::Propagate() const {
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	typename Variable::Value min_sum = this->min_sum;
+	typename Variable::Value max_sum = this->max_sum;
+	if ( !attached ) {
+		min_sum = max_sum = 0;
+		for ( ; b!=e; ++b ) {
+			min_sum += (*b)->GetMinValue();
+			max_sum += (*b)->GetMaxValue();
+		}
+	}
+	if ( min_sum > SUM || max_sum < SUM ) return false;
+
+	for ( b = this->vars.begin(); b!=e; ++b ) {
+		if ( (*b)->IsAssigned() ) continue;
+		typename Variable::Value min = (*b)->GetMinValue();
+		typename Variable::Value max = (*b)->GetMaxValue();
+		//range of values the others leave for this variable
+		typename Variable::Value lo = SUM - ( max_sum - max );
+		typename Variable::Value hi = SUM - ( min_sum - min );
+		if ( min >= lo && max <= hi ) continue;
+		while ( (*b)->GetMinValue() < lo ) {
+			(*b)->RemoveValue( (*b)->GetMinValue() );
+			if ( (*b)->IsImpossible() ) return false;
+		}
+		while ( (*b)->GetMaxValue() > hi ) {
+			(*b)->RemoveValue( (*b)->GetMaxValue() );
+			if ( (*b)->IsImpossible() ) return false;
+		}
+		min_sum += (*b)->GetMinValue() - min;
+		max_sum += (*b)->GetMaxValue() - max;
+	}
+	return true;
+}
+////////////////////////////////////////////////////////////
 template <typename Variable, int SUM>
 void SumEqual<Variable,SUM>::Print (std::ostream& os) const {
 	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
@@ -264,6 +882,7 @@ AllDiff<Variable>* AllDiff<Variable>::clone () const {
 	for ( ; b!=e; ++b ) {
 		copy->AddVariable(*b);
 	}
+	copy->SetConsistency( consistency );
 	return copy;
 }
 
@@ -283,24 +902,383 @@ void AllDiff<Variable>::Print (std::ostream& os) const {
 }
 
 ////////////////////////////////////////////////////////////
-//constraint is true if all currently assigned variables have 
-//different values
+template <typename Variable>
+void AllDiff<Variable>::Cover(std::vector<unsigned>& a, Value& base, Value val) {
+	if ( a.empty() ) {
+		base = val;
+		a.resize( 1, 0 );
+	} else if ( val < base ) {
+		a.insert( a.begin(), base - val, 0 );
+		base = val;
+	} else if ( val - base >= static_cast<Value>( a.size() ) ) {
+		a.resize( val - base + 1, 0 );
+	}
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void AllDiff<Variable>::Attach() {
+	if ( attached ) return;
+	counted.assign( this->vars.size(), Value() );
+	is_counted.assign( this->vars.size(), false );
+	propagated.assign( this->vars.size(), false );
+	conflicts = 0;
+	for ( unsigned i=0; i<this->vars.size(); ++i ) {
+		Changed( this->vars[i], i );
+		this->vars[i]->AddObserver( this, i );
+	}
+	attached = true;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void AllDiff<Variable>::Detach() {
+	if ( !attached ) return;
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	for ( ; b!=e; ++b ) {
+		(*b)->RemoveObserver( this );
+	}
+	std::fill( counts.begin(), counts.end(), 0 );
+	std::fill( holders.begin(), holders.end(), 0 );
+	attached = false;
+}
+////////////////////////////////////////////////////////////
+//neither assignment nor unassignment means SetDomain - values may
+//have come back anywhere
+template <typename Variable>
+INLINE void AllDiff<Variable>::Changed(Variable* var, unsigned i) {
+	bool const was_counted = is_counted[i];
+	Value const old = counted[i];
+	if ( was_counted ) {
+		unsigned const w = old - count_base;
+		if ( --counts[w] == 1 ) --conflicts;
+		if ( holders[w] == i+1 ) {
+			holders[w] = 0;
+			//the other holder of a value taken twice is not known
+			if ( counts[w] > 0 ) std::fill( propagated.begin(), propagated.end(), false );
+		}
+		is_counted[i] = false;
+	}
+	if ( var->IsAssigned() ) {
+		Value const val = var->GetValue();
+		Value const old_base = count_base;
+		Cover( counts, count_base, val );
+		if ( !holders.empty() ) holders.insert( holders.begin(), old_base - count_base, 0 );
+		holders.resize( counts.size(), 0 );
+		unsigned const w = val - count_base;
+		if ( ++counts[w] == 2 ) ++conflicts;
+		if ( holders[w] == 0 ) holders[w] = i+1;
+		counted[i] = val;
+		is_counted[i] = true;
+	}
+	if ( was_counted == is_counted[i] && ( !was_counted || old == counted[i] ) ) {
+		std::fill( propagated.begin(), propagated.end(), false );
+	}
+	propagated[i] = false;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+INLINE void AllDiff<Variable>::Restored(Variable*, unsigned, Value val) {
+	if ( val < count_base || val - count_base >= static_cast<Value>( holders.size() ) ) return;
+	unsigned const holder = holders[ val - count_base ];
+	if ( holder ) propagated[ holder-1 ] = false;
+}
+////////////////////////////////////////////////////////////
+//constraint is true if all currently assigned variables have
+//different values. Unless attached a value is seen twice if its 
+//stamp is the one of this call (the stamp array grows to new 
+//values, no other allocation)
 template <typename Variable>
 INLINE bool AllDiff<Variable>::Satisfiable() const {
+	if ( attached ) return conflicts == 0;
+	if ( ++seen_stamp == 0 ) {
+		std::fill( seen.begin(), seen.end(), 0 );
+		seen_stamp = 1;
+	}
 	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
 	typename std::vector<Variable*>::const_iterator e = this->vars.end();
-	typename std::set<typename Variable::Value> values;
-
-	unsigned counter = 0;
 	for ( ; b!=e; ++b ) {
-		if ( (*b)->IsAssigned() ) {
-			++counter;
-			values.insert( (*b)->GetValue() );
-			if (counter != values.size()) return false; //if not equal - we have seen duplicates
+		if ( ! (*b)->IsAssigned() ) continue;
+		Value val = (*b)->GetValue();
+		Cover( seen, seen_base, val );
+		unsigned& stamp = seen[ val - seen_base ];
+		if ( stamp == seen_stamp ) return false;
+		stamp = seen_stamp;
+	}
+	return true;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+INLINE bool AllDiff<Variable>::Propagate() const {
+	switch ( consistency ) {
+		case BOUNDS: return PropagateBounds();
+		case GAC:    return PropagateGAC();
+		default:     return PropagateValues();
+	}
+}
+////////////////////////////////////////////////////////////
+//values of fixed variables are removed from the others (if 
+//attached - of assigned ones not propagated yet, singletons left by
+//propagation are not tracked, so they are propagated every time)
+template <typename Variable>
+INLINE bool AllDiff<Variable>::PropagateValues() const {
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	for ( ; b!=e; ++b ) {
+		bool const assigned = (*b)->IsAssigned();
+		if ( ! assigned && (*b)->SizeDomain() != 1 ) continue;
+		if ( assigned && attached && propagated[ b - this->vars.begin() ] ) continue;
+		typename Variable::Value val = this->FixedValue( *b );
+		typename std::vector<Variable*>::const_iterator b2 = this->vars.begin();
+		for ( ; b2!=e; ++b2 ) {
+			if ( b2 == b ) continue;
+			if ( (*b2)->IsAssigned() ) {
+				if ( (*b2)->GetValue() == val ) return false;
+			}
+			else if ( ! this->Prune( *b2, val ) ) return false;
 		}
+		if ( assigned && attached ) propagated[ b - this->vars.begin() ] = true;
 	}
 	return true;
 }
+////////////////////////////////////////////////////////////
+//[L,U] is a Hall interval if as many variables have both bounds
+//in it as it has values - the other variables cannot use them.
+//For each lower bound L variables are counted in order of their
+//upper bounds, which gives all Hall intervals [L,U] at once, then
+//each variable is pruned by the largest of them it sticks out of
+//(binary search) - O(n^2 log n) per pass. Domains only shrink, so
+//intervals found from the bounds at the start of a pass stay Hall
+//intervals while the pass prunes, passes repeat until no bound moves
+template <typename Variable>
+bool AllDiff<Variable>::PropagateBounds() const {
+	unsigned const n = this->vars.size();
+	mins.resize( n );
+	maxs.resize( n );
+	by_max.resize( n );
+	bool changed = true;
+	while ( changed ) {
+		changed = false;
+		for ( unsigned i=0; i<n; ++i ) {
+			mins[i] = this->vars[i]->GetMinValue();
+			maxs[i] = this->vars[i]->GetMaxValue();
+			//insertion sort by upper bound
+			unsigned j = i;
+			for ( ; j>0 && maxs[ by_max[j-1] ] > maxs[i]; --j ) by_max[j] = by_max[j-1];
+			by_max[j] = i;
+		}
+		for ( unsigned l=0; l<n; ++l ) {
+			Value const L = mins[l];
+			//each lower bound once
+			unsigned first = 0;
+			while ( mins[first] != L ) ++first;
+			if ( first < l ) continue;
+			//upper bounds come in increasing order
+			hall.clear();
+			Value count = 0;
+			for ( unsigned k=0; k<n; ++k ) {
+				if ( mins[ by_max[k] ] < L ) continue;
+				Value const U = maxs[ by_max[k] ];
+				++count;
+				if ( count > U-L+1 ) return false;
+				if ( count == U-L+1 ) hall.push_back( U );
+			}
+			if ( hall.empty() ) continue;
+			for ( unsigned i=0; i<n; ++i ) {
+				if ( maxs[i] < L ) continue;
+				//a variable not inside [L,U] is not assigned to a value in it
+				Variable* var = this->vars[i];
+				if ( mins[i] >= L ) {
+					//the min moves past the largest interval ending below the max
+					typename std::vector<Value>::const_iterator const inside = 
+						std::lower_bound( hall.begin(), hall.end(), maxs[i] );
+					if ( inside == hall.begin() ) continue;
+					Value const U = *( inside - 1 );
+					while ( var->GetMinValue() <= U ) {
+						var->RemoveValue( var->GetMinValue() );
+						if ( var->IsImpossible() ) return false;
+						changed = true;
+					}
+				}
+				else if ( maxs[i] <= hall.back() ) {
+					//the max is in some interval, the min below all of them
+					while ( var->GetMaxValue() >= L ) {
+						var->RemoveValue( var->GetMaxValue() );
+						if ( var->IsImpossible() ) return false;
+						changed = true;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+////////////////////////////////////////////////////////////
+//Regin: find a matching variables -> values covering all variables
+//(starting from the previous one), then value (x,v) is in some
+//solution iff it is matched, or x and v are in the same strongly
+//connected component of the value graph: matched edges go from
+//variable to value, others from value to variable, matched values
+//lead to an extra node leading to all free values (even alternating
+//paths from a free value become cycles)
+template <typename Variable>
+bool AllDiff<Variable>::PropagateGAC() const {
+	unsigned const n = this->vars.size();
+	Value lo = this->vars[0]->GetMinValue();
+	Value hi = this->vars[0]->GetMaxValue();
+	for ( unsigned i=1; i<n; ++i ) {
+		lo = std::min( lo, this->vars[i]->GetMinValue() );
+		hi = std::max( hi, this->vars[i]->GetMaxValue() );
+	}
+	if ( hi-lo+1 < static_cast<Value>(n) ) return false;
+	unsigned const m = hi-lo+1;
+
+	//values of each variable (index value-lo), assigned variable
+	//has only its value
+	adj_offsets.resize( n+1 );
+	adj.clear();
+	for ( unsigned i=0; i<n; ++i ) {
+		adj_offsets[i] = adj.size();
+		Variable* var = this->vars[i];
+		if ( var->IsAssigned() ) { adj.push_back( var->GetValue() - lo ); continue; }
+		typename Variable::Domain::const_iterator b_dom = var->GetDomain().begin();
+		typename Variable::Domain::const_iterator e_dom = var->GetDomain().end();
+		for ( ; b_dom!=e_dom; ++b_dom ) adj.push_back( *b_dom - lo );
+	}
+	adj_offsets[n] = adj.size();
+	//variables of each value (counting sort, lowlink is scratch here)
+	val_offsets.assign( m+1, 0 );
+	for ( unsigned k=0; k<adj.size(); ++k ) ++val_offsets[ adj[k]+1 ];
+	for ( unsigned w=0; w<m; ++w ) val_offsets[w+1] += val_offsets[w];
+	val_adj.resize( adj.size() );
+	lowlink.assign( val_offsets.begin(), val_offsets.end()-1 );
+	for ( unsigned i=0; i<n; ++i ) {
+		for ( unsigned k=adj_offsets[i]; k<adj_offsets[i+1]; ++k ) val_adj[ lowlink[ adj[k] ]++ ] = i;
+	}
+
+	//keep matched pairs that are still possible, augment the rest
+	match.resize( n );
+	has_match.resize( n, false );
+	val_match.assign( m, -1 );
+	for ( unsigned i=0; i<n; ++i ) {
+		if ( ! has_match[i] ) continue;
+		Variable* var = this->vars[i];
+		Value val = match[i];
+		bool possible = var->IsAssigned() ? val == var->GetValue() : var->GetDomain().Contains(val);
+		if ( possible && val_match[val-lo] < 0 ) val_match[val-lo] = i;
+		else has_match[i] = false;
+	}
+	pred.resize( m );
+	visit_stamp.resize( n, 0 );
+	for ( unsigned i=0; i<n; ++i ) {
+		if ( ! has_match[i] && ! Augment( i, lo ) ) return false;
+	}
+
+	//components, node n+m is the extra node
+	index.assign( n+m+1, ~0u );
+	lowlink.resize( n+m+1 );
+	scc.resize( n+m+1 );
+	on_stack.assign( n+m+1, false );
+	stack.clear();
+	next_index = num_scc = 0;
+	for ( unsigned v=0; v<n+m+1; ++v ) {
+		if ( index[v] == ~0u ) StrongConnect( v, n, lo );
+	}
+
+	for ( unsigned i=0; i<n; ++i ) {
+		Variable* var = this->vars[i];
+		if ( var->IsAssigned() ) continue;
+		for ( unsigned k=adj_offsets[i]; k<adj_offsets[i+1]; ++k ) {
+			Value val = adj[k] + lo;
+			if ( val != match[i] && scc[i] != scc[ n+adj[k] ] ) var->RemoveValue( val );
+		}
+	}
+	return true;
+}
+////////////////////////////////////////////////////////////
+//BFS over alternating paths from unmatched variable x to a free
+//value, the path is flipped - returns false if there is none
+template <typename Variable>
+bool AllDiff<Variable>::Augment(unsigned x, Value lo) const {
+	if ( ++visit == 0 ) {
+		std::fill( visit_stamp.begin(), visit_stamp.end(), 0 );
+		visit = 1;
+	}
+	bfs.clear();
+	bfs.push_back( x );
+	visit_stamp[x] = visit;
+	for ( unsigned q=0; q<bfs.size(); ++q ) {
+		unsigned y = bfs[q];
+		for ( unsigned k=adj_offsets[y]; k<adj_offsets[y+1]; ++k ) {
+			unsigned w = adj[k];
+			int z = val_match[w];
+			if ( z >= 0 && visit_stamp[z] == visit ) continue;
+			pred[w] = y;
+			if ( z >= 0 ) {
+				visit_stamp[z] = visit;
+				bfs.push_back( z );
+				continue;
+			}
+			//free value - each variable on the path takes the value
+			//it was reached from, only x was not matched before
+			for ( ;; ) {
+				unsigned v = pred[w];
+				bool const root = ! has_match[v];
+				unsigned next = root ? 0 : match[v]-lo;
+				match[v] = w+lo;
+				has_match[v] = true;
+				val_match[w] = v;
+				if ( root ) return true;
+				w = next;
+			}
+		}
+	}
+	return false;
+}
+////////////////////////////////////////////////////////////
+//Tarjan, recursion depth is at most the number of nodes
+template <typename Variable>
+void AllDiff<Variable>::StrongConnect(unsigned v, unsigned n, Value lo) const {
+	unsigned const m = val_match.size();
+	index[v] = lowlink[v] = next_index++;
+	stack.push_back( v );
+	on_stack[v] = true;
+
+	if ( v < n ) {
+		Successor( v, n + match[v]-lo, n, lo );
+	} else if ( v < n+m ) {
+		unsigned const w = v-n;
+		for ( unsigned k=val_offsets[w]; k<val_offsets[w+1]; ++k ) {
+			if ( static_cast<int>( val_adj[k] ) != val_match[w] ) Successor( v, val_adj[k], n, lo );
+		}
+		if ( val_match[w] >= 0 ) Successor( v, n+m, n, lo );
+	} else {
+		for ( unsigned w=0; w<m; ++w ) {
+			if ( val_match[w] < 0 ) Successor( v, n+w, n, lo );
+		}
+	}
+
+	if ( lowlink[v] == index[v] ) {
+		unsigned u;
+		do {
+			u = stack.back();
+			stack.pop_back();
+			on_stack[u] = false;
+			scc[u] = num_scc;
+		} while ( u != v );
+		++num_scc;
+	}
+}
+////////////////////////////////////////////////////////////
+//edge v->u of StrongConnect
+template <typename Variable>
+INLINE void AllDiff<Variable>::Successor(unsigned v, unsigned u, unsigned n, Value lo) const {
+	if ( index[u] == ~0u ) {
+		StrongConnect( u, n, lo );
+		lowlink[v] = std::min( lowlink[v], lowlink[u] );
+	} else if ( on_stack[u] ) {
+		lowlink[v] = std::min( lowlink[v], index[u] );
+	}
+}
 
 ////////////////////////////////////////////////////////////
 //AllDiff2 implementation
@@ -330,6 +1308,41 @@ INLINE bool AllDiff2<Variable>::Satisfiable() const {
 		return this->vars[0]->GetValue() != this->vars[1]->GetValue();
 }
 
+////////////////////////////////////////////////////////////
+//once one variable is fixed its value is removed from the other one
+template <typename Variable>
+INLINE bool AllDiff2<Variable>::Propagate() const {
+	Variable* v0 = this->vars[0];
+	Variable* v1 = this->vars[1];
+	if ( this->IsFixed( v0 ) ) {
+		if ( this->IsFixed( v1 ) ) return this->FixedValue( v0 ) != this->FixedValue( v1 );
+		return this->Prune( v1, this->FixedValue( v0 ) );
+	}
+	if ( this->IsFixed( v1 ) ) return this->Prune( v0, this->FixedValue( v1 ) );
+	return true;
+}
+////////////////////////////////////////////////////////////
+//unassigned variables are disjoint if their bounds are
+template <typename Variable>
+INLINE bool AllDiff2<Variable>::Entailed() const {
+	Variable* v0 = this->vars[0];
+	Variable* v1 = this->vars[1];
+	if ( v0->IsAssigned() ) {
+		if ( v1->IsAssigned() ) return v0->GetValue() != v1->GetValue();
+		return ! v1->GetDomain().Contains( v0->GetValue() );
+	}
+	if ( v1->IsAssigned() ) return ! v0->GetDomain().Contains( v1->GetValue() );
+	return v0->GetMaxValue() < v1->GetMinValue() || v1->GetMaxValue() < v0->GetMinValue();
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void AllDiff2<Variable>::Supports(unsigned i, typename Variable::Value val, 
+		typename Variable::Domain::Word* row) const {
+	const typename Variable::Domain& dom = this->vars[1-i]->GetDomain();
+	this->SetBits( dom, row );
+	this->ClearBit( dom, val, row );
+}
+
 ////////////////////////////////////////////////////////////
 //DifferenceNotEqual implementation
 ////////////////////////////////////////////////////////////
@@ -381,6 +1394,560 @@ INLINE bool DifferenceNotEqual<Variable>::Satisfiable() const {
 	else 
 		return std::abs( this->vars[0]->GetValue() - this->vars[1]->GetValue() ) != constant;
 }
+
+////////////////////////////////////////////////////////////
+//once one variable is fixed its value plus/minus the constant
+//is removed from the other one
+template <typename Variable>
+INLINE bool DifferenceNotEqual<Variable>::Propagate() const {
+	Variable* v0 = this->vars[0];
+	Variable* v1 = this->vars[1];
+	bool const fixed0 = this->IsFixed( v0 );
+	bool const fixed1 = this->IsFixed( v1 );
+	if ( fixed0 && fixed1 ) {
+		typename Variable::Value const diff = this->FixedValue( v0 ) - this->FixedValue( v1 );
+		return diff != constant && diff != -constant;
+	}
+	if ( !fixed0 && !fixed1 ) return true;
+	Variable* other = fixed0 ? v1 : v0;
+	typename Variable::Value val = this->FixedValue( fixed0 ? v0 : v1 );
+	return this->Prune( other, val + constant ) && this->Prune( other, val - constant );
+}
+////////////////////////////////////////////////////////////
+//both unassigned - not checked
+template <typename Variable>
+INLINE bool DifferenceNotEqual<Variable>::Entailed() const {
+	Variable* v0 = this->vars[0];
+	Variable* v1 = this->vars[1];
+	if ( v0->IsAssigned() && v1->IsAssigned() ) return Satisfiable();
+	if ( !v0->IsAssigned() && !v1->IsAssigned() ) return false;
+	Variable* other = v0->IsAssigned() ? v1 : v0;
+	typename Variable::Value val = v0->IsAssigned() ? v0->GetValue() : v1->GetValue();
+	return ! other->GetDomain().Contains( val + constant ) && 
+		! other->GetDomain().Contains( val - constant );
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void DifferenceNotEqual<Variable>::Supports(unsigned i, typename Variable::Value val, 
+		typename Variable::Domain::Word* row) const {
+	const typename Variable::Domain& dom = this->vars[1-i]->GetDomain();
+	this->SetBits( dom, row );
+	this->ClearBit( dom, val + constant, row );
+	this->ClearBit( dom, val - constant, row );
+}
+////////////////////////////////////////////////////////////
+//Table implementation
+////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////
+template <typename Variable>
+Table<Variable>* Table<Variable>::clone () const { 
+	Table<Variable>* copy = new Table<Variable>();
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	for ( ; b!=e; ++b ) {
+		copy->AddVariable(*b);
+	}
+	copy->tuples = tuples;
+	return copy;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void Table<Variable>::Print (std::ostream& os) const {
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	os << "CONSTRAINT: " << NumTuples() << " tuples of ";
+	for ( ; b!=e; ++b ) {
+		os << (*b)->Name() << " ";
+	}
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void Table<Variable>::AddTuple(const std::vector<Value>& tuple) {
+	if ( tuple.size() != this->vars.size() ) throw "Table::AddTuple - wrong number of values";
+	tuples.insert( tuples.end(), tuple.begin(), tuple.end() );
+}
+////////////////////////////////////////////////////////////
+//one bit per tuple in the mask of each of its values
+template <typename Variable>
+void Table<Variable>::Attach() {
+	if ( attached ) return;
+	unsigned const n = this->vars.size();
+	unsigned const num_tuples = NumTuples();
+	values.assign( n, std::vector<Value>() );
+	mask_offsets.assign( n+1, 0 );
+	for ( unsigned i=0; i<n; ++i ) {
+		for ( unsigned t=0; t<num_tuples; ++t ) values[i].push_back( tuples[ t*n+i ] );
+		std::sort( values[i].begin(), values[i].end() );
+		values[i].erase( std::unique( values[i].begin(), values[i].end() ), values[i].end() );
+		mask_offsets[i+1] = mask_offsets[i] + values[i].size();
+	}
+	num_words = ( num_tuples + Variable::Domain::BITS - 1 ) / Variable::Domain::BITS;
+	masks.assign( mask_offsets[n] * num_words, 0 );
+	for ( unsigned t=0; t<num_tuples; ++t ) {
+		for ( unsigned i=0; i<n; ++i ) {
+			Word* m = &masks[ ( mask_offsets[i] + Find( i, tuples[ t*n+i ] ) ) * num_words ];
+			m[ t / Variable::Domain::BITS ] |= Word(1) << ( t % Variable::Domain::BITS );
+		}
+	}
+	residues.assign( mask_offsets[n], 0 );
+	words.resize( num_words );
+	index.resize( num_words );
+	word_frame.assign( num_words, 0 );
+	frame_serial = 0;
+	valid.assign( num_words, 0 );
+	mask.assign( num_words, 0 );
+	removals = 0;
+	is_assigned.assign( n, false );
+	assigned_value.assign( n, Value() );
+	for ( unsigned i=0; i<n; ++i ) {
+		is_assigned[i] = this->vars[i]->IsAssigned();
+		if ( is_assigned[i] ) assigned_value[i] = this->vars[i]->GetValue();
+		this->vars[i]->AddObserver( this, i );
+	}
+	Rebuild();
+	attached = true;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void Table<Variable>::Detach() {
+	if ( !attached ) return;
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	for ( ; b!=e; ++b ) {
+		(*b)->RemoveObserver( this );
+	}
+	attached = false;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+INLINE int Table<Variable>::Find(unsigned i, Value val) const {
+	typename std::vector<Value>::const_iterator it = 
+		std::lower_bound( values[i].begin(), values[i].end(), val );
+	if ( it == values[i].end() || *it != val ) return -1;
+	return it - values[i].begin();
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void Table<Variable>::Rebuild() {
+	unsigned const num_tuples = NumTuples();
+	unsigned const word_bits = Variable::Domain::BITS;
+	for ( unsigned w=0; w<num_words; ++w ) {
+		unsigned const bits = std::min( num_tuples - w*word_bits, word_bits );
+		words[w] = bits == word_bits ? ~Word(0) : ( Word(1) << bits ) - 1;
+		index[w] = w;
+	}
+	limit = num_words;
+	frames.clear();
+	saved_words.clear();
+	saved_sizes.clear();
+	last_size.assign( this->vars.size(), ~0u );
+	delta.assign( this->vars.size(), std::vector<Value>() );
+	reset.assign( this->vars.size(), true );
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+INLINE void Table<Variable>::Removed(Variable*, unsigned i, Value val) {
+	++removals;
+	if ( reset[i] ) return;
+	if ( delta[i].size() < values[i].size() ) delta[i].push_back(val);
+	else { delta[i].clear(); reset[i] = true; }
+}
+////////////////////////////////////////////////////////////
+//the trail restores in reverse order of removal - frames opened
+//after the removal are dropped (the variables changed since the 
+//frame below are read again), otherwise val is the last value in 
+//the delta
+template <typename Variable>
+INLINE void Table<Variable>::Restored(Variable*, unsigned i, Value val) {
+	--removals;
+	if ( !frames.empty() && frames.back().tag > removals ) {
+		while ( !frames.empty() && frames.back().tag > removals ) PopFrame();
+		for ( unsigned j=0; j<this->vars.size(); ++j ) {
+			delta[j].clear();
+			reset[j] = true;
+		}
+		return;
+	}
+	if ( !delta[i].empty() && delta[i].back() == val ) delta[i].pop_back();
+	else { delta[i].clear(); reset[i] = true; }
+}
+////////////////////////////////////////////////////////////
+//neither assignment nor unassignment means SetDomain - values may
+//have come back anywhere
+template <typename Variable>
+INLINE void Table<Variable>::Changed(Variable* var, unsigned i) {
+	bool const was_assigned = is_assigned[i];
+	Value const old = assigned_value[i];
+	is_assigned[i] = var->IsAssigned();
+	if ( is_assigned[i] ) assigned_value[i] = var->GetValue();
+	if ( was_assigned == is_assigned[i] && ( !was_assigned || old == assigned_value[i] ) ) Rebuild();
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+INLINE bool Table<Variable>::Fix() const {
+	fixed.clear();
+	for ( unsigned i=0; i<this->vars.size(); ++i ) {
+		if ( ! this->vars[i]->IsAssigned() ) continue;
+		int k = Find( i, this->vars[i]->GetValue() );
+		if ( k < 0 ) return false;
+		fixed.push_back( Mask(i,k) );
+	}
+	return true;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void Table<Variable>::OpenFrame() const {
+	if ( ++frame_serial == 0 ) {
+		std::fill( word_frame.begin(), word_frame.end(), 0 );
+		frame_serial = 1;
+	}
+	frames.push_back( Frame( removals, saved_words.size(), saved_sizes.size(), limit ) );
+}
+////////////////////////////////////////////////////////////
+//words zeroed in the frame were swapped to index[limit..], so the 
+//old limit covers them again
+template <typename Variable>
+void Table<Variable>::PopFrame() {
+	Frame const& f = frames.back();
+	for ( ; saved_words.size() > f.num_saved_words; saved_words.pop_back() ) {
+		words[ saved_words.back().first ] = saved_words.back().second;
+	}
+	for ( ; saved_sizes.size() > f.num_saved_sizes; saved_sizes.pop_back() ) {
+		last_size[ saved_sizes.back().first ] = saved_sizes.back().second;
+	}
+	limit = f.limit;
+	frames.pop_back();
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+INLINE void Table<Variable>::Intersect(bool negate) const {
+	for ( unsigned k=limit; k-- > 0; ) {
+		unsigned const w = index[k];
+		Word const updated = words[w] & ( negate ? ~mask[w] : mask[w] );
+		if ( updated == words[w] ) continue;
+		if ( word_frame[w] != frame_serial ) {
+			word_frame[w] = frame_serial;
+			saved_words.push_back( std::make_pair( w, words[w] ) );
+		}
+		words[w] = updated;
+		if ( updated == 0 ) {
+			index[k] = index[limit-1];
+			index[limit-1] = w;
+			--limit;
+		}
+	}
+}
+////////////////////////////////////////////////////////////
+//a variable whose domain size did not change since the last update
+//has the same domain (there were only removals since then)
+template <typename Variable>
+void Table<Variable>::Update() const {
+	bool open = false;
+	for ( unsigned i=0; i<this->vars.size(); ++i ) {
+		Variable* var = this->vars[i];
+		unsigned const size = var->SizeDomain();
+		if ( size == last_size[i] ) continue;
+		if ( !open ) { OpenFrame(); open = true; }
+		bool const by_delta = !reset[i] && delta[i].size() < size;
+		for ( unsigned k=0; k<limit; ++k ) mask[ index[k] ] = 0;
+		if ( by_delta ) {
+			typename std::vector<Value>::const_iterator b_v = delta[i].begin();
+			typename std::vector<Value>::const_iterator e_v = delta[i].end();
+			for ( ; b_v!=e_v; ++b_v ) {
+				int v = Find( i, *b_v );
+				if ( v < 0 ) continue;
+				const Word* m = Mask( i, v );
+				for ( unsigned k=0; k<limit; ++k ) mask[ index[k] ] |= m[ index[k] ];
+			}
+		} else {
+			typename Variable::Domain::const_iterator b_dom = var->GetDomain().begin();
+			typename Variable::Domain::const_iterator e_dom = var->GetDomain().end();
+			for ( ; b_dom!=e_dom; ++b_dom ) {
+				int v = Find( i, *b_dom );
+				if ( v < 0 ) continue;
+				const Word* m = Mask( i, v );
+				for ( unsigned k=0; k<limit; ++k ) mask[ index[k] ] |= m[ index[k] ];
+			}
+		}
+		Intersect( by_delta );
+		saved_sizes.push_back( std::make_pair( i, last_size[i] ) );
+		last_size[i] = size;
+		delta[i].clear();
+		reset[i] = false;
+	}
+}
+////////////////////////////////////////////////////////////
+//unless attached the tuples are scanned
+template <typename Variable>
+INLINE bool Table<Variable>::Satisfiable() const {
+	if ( !attached ) {
+		unsigned const n = this->vars.size();
+		for ( unsigned t=0; t<NumTuples(); ++t ) {
+			unsigned i = 0;
+			for ( ; i<n; ++i ) {
+				Variable* var = this->vars[i];
+				Value const val = tuples[ t*n+i ];
+				if ( var->IsAssigned() ? var->GetValue() != val : !var->GetDomain().Contains(val) ) break;
+			}
+			if ( i == n ) return true;
+		}
+		return false;
+	}
+	if ( !Fix() ) return false;
+	for ( unsigned k=0; k<limit; ++k ) {
+		unsigned const w = index[k];
+		Word v = words[w];
+		typename std::vector<const Word*>::const_iterator b_f = fixed.begin();
+		typename std::vector<const Word*>::const_iterator e_f = fixed.end();
+		for ( ; b_f!=e_f && v; ++b_f ) v &= (*b_f)[w];
+		if ( v ) return true;
+	}
+	return false;
+}
+////////////////////////////////////////////////////////////
+//a value is supported if its mask meets a valid tuple, the word 
+//where it did last time is tried first
+template <typename Variable>
+bool Table<Variable>::Propagate() const {
+	if ( !attached ) return Constraint<Variable>::Propagate();
+	Update();
+	if ( !Fix() ) return false;
+
+	std::fill( valid.begin(), valid.end(), 0 );
+	bool any = false;
+	for ( unsigned k=0; k<limit; ++k ) {
+		unsigned const w = index[k];
+		Word v = words[w];
+		typename std::vector<const Word*>::const_iterator b_f = fixed.begin();
+		typename std::vector<const Word*>::const_iterator e_f = fixed.end();
+		for ( ; b_f!=e_f && v; ++b_f ) v &= (*b_f)[w];
+		valid[w] = v;
+		any = any || v;
+	}
+	if ( !any ) return false;
+
+	for ( unsigned i=0; i<this->vars.size(); ++i ) {
+		Variable* var = this->vars[i];
+		if ( var->IsAssigned() ) continue;
+		//values are removed after the scan - removal may reorder the domain
+		this->inconsistent.clear();
+		typename Variable::Domain::const_iterator b_dom = var->GetDomain().begin();
+		typename Variable::Domain::const_iterator e_dom = var->GetDomain().end();
+		for ( ; b_dom!=e_dom; ++b_dom ) {
+			int v = Find( i, *b_dom );
+			if ( v < 0 ) { this->inconsistent.push_back(*b_dom); continue; }
+			const Word* m = Mask( i, v );
+			unsigned& residue = residues[ mask_offsets[i]+v ];
+			if ( valid[residue] & m[residue] ) continue;
+			unsigned k = 0;
+			for ( ; k<limit && !( valid[ index[k] ] & m[ index[k] ] ); ++k ) {}
+			if ( k < limit ) residue = index[k];
+			else this->inconsistent.push_back(*b_dom);
+		}
+		typename std::vector<Value>::const_iterator b_v = this->inconsistent.begin();
+		typename std::vector<Value>::const_iterator e_v = this->inconsistent.end();
+		for ( ; b_v!=e_v; ++b_v ) {
+			var->RemoveValue(*b_v);
+		}
+		if ( var->IsImpossible() ) return false;
+	}
+	return true;
+}
+////////////////////////////////////////////////////////////
+//Queens implementation
+////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////
+template <typename Variable>
+Queens<Variable>* Queens<Variable>::clone () const { 
+	Queens<Variable>* copy = new Queens<Variable>();
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	for ( ; b!=e; ++b ) {
+		copy->AddVariable(*b);
+	}
+	return copy;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void Queens<Variable>::Print (std::ostream& os) const {
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	os << "CONSTRAINT: queens ";
+	for ( ; b!=e; ++b ) {
+		os << (*b)->Name() << " ";
+	}
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void Queens<Variable>::Attach() {
+	if ( attached ) return;
+	Recount();
+	for ( unsigned i=0; i<this->vars.size(); ++i ) {
+		this->vars[i]->AddObserver( this, i );
+	}
+	attached = true;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void Queens<Variable>::Detach() {
+	if ( !attached ) return;
+	typename std::vector<Variable*>::const_iterator b = this->vars.begin();
+	typename std::vector<Variable*>::const_iterator e = this->vars.end();
+	for ( ; b!=e; ++b ) {
+		(*b)->RemoveObserver( this );
+	}
+	attached = false;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+void Queens<Variable>::Recount() const {
+	unsigned const n = this->vars.size();
+	bool first = true;
+	for ( unsigned i=0; i<n; ++i ) {
+		Variable* var = this->vars[i];
+		if ( !var->IsAssigned() && var->IsImpossible() ) continue;
+		Value const min = var->IsAssigned() ? var->GetValue() : var->GetMinValue();
+		Value const max = var->IsAssigned() ? var->GetValue() : var->GetMaxValue();
+		if ( first || min < lo ) lo = min;
+		if ( first || max > hi ) hi = max;
+		first = false;
+	}
+	unsigned const num_rows = first ? 0 : hi-lo+1;
+	rows.assign( num_rows, 0 );
+	diagonals.assign( num_rows+n, 0 );
+	anti_diagonals.assign( num_rows+n, 0 );
+	conflicts = 0;
+	counted.assign( n, Value() );
+	is_counted.assign( n, false );
+	for ( unsigned i=0; i<n; ++i ) {
+		if ( !this->vars[i]->IsAssigned() ) continue;
+		counted[i] = this->vars[i]->GetValue();
+		is_counted[i] = true;
+		Count( i, counted[i], 1 );
+	}
+	pending.clear();
+	is_pending.assign( n, false );
+	propagated.assign( n, false );
+	propagate_all = true;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+INLINE void Queens<Variable>::Count(unsigned i, Value val, int delta) const {
+	unsigned const r = val - lo;
+	Move( rows[r], delta );
+	Move( diagonals[ r+i ], delta );
+	Move( anti_diagonals[ r + this->vars.size()-1 - i ], delta );
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+INLINE void Queens<Variable>::Move(unsigned& counter, int delta) const {
+	if ( delta > 0 ) {
+		if ( counter++ > 0 ) ++conflicts;
+	} else {
+		if ( --counter > 0 ) --conflicts;
+	}
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+INLINE bool Queens<Variable>::Attacked(unsigned i, Value val) const {
+	if ( val < lo || val > hi ) return false;
+	unsigned const r = val - lo;
+	return rows[r] || diagonals[ r+i ] || anti_diagonals[ r + this->vars.size()-1 - i ];
+}
+////////////////////////////////////////////////////////////
+//neither assignment nor unassignment means SetDomain - values may
+//have come back anywhere
+template <typename Variable>
+INLINE void Queens<Variable>::Changed(Variable* var, unsigned i) {
+	bool const was_counted = is_counted[i];
+	Value const old = counted[i];
+	if ( was_counted ) {
+		Count( i, old, -1 );
+		is_counted[i] = false;
+	}
+	if ( var->IsAssigned() ) {
+		Value const val = var->GetValue();
+		if ( val < lo || val > hi ) {
+			Recount();
+		} else {
+			Count( i, val, 1 );
+			counted[i] = val;
+			is_counted[i] = true;
+		}
+		if ( !is_pending[i] ) {
+			is_pending[i] = true;
+			pending.push_back( i );
+		}
+	}
+	if ( was_counted == is_counted[i] && ( !was_counted || old == counted[i] ) ) {
+		propagate_all = true;
+	}
+	propagated[i] = false;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+INLINE void Queens<Variable>::Restored(Variable*, unsigned i, Value val) {
+	if ( Attacked( i, val ) ) propagate_all = true;
+}
+////////////////////////////////////////////////////////////
+template <typename Variable>
+INLINE bool Queens<Variable>::Satisfiable() const {
+	if ( !attached ) Recount();
+	return conflicts == 0;
+}
+////////////////////////////////////////////////////////////
+//O(n) for each queen, a failure leaves the queen pending (the trail
+//takes back what it pruned)
+template <typename Variable>
+INLINE bool Queens<Variable>::Propagate() const {
+	if ( !attached ) Recount();
+	if ( conflicts ) return false;
+	unsigned const n = this->vars.size();
+	if ( propagate_all ) {
+		propagate_all = false;
+		for ( unsigned i=0; i<n; ++i ) {
+			propagated[i] = false;
+			if ( this->vars[i]->IsAssigned() && !is_pending[i] ) {
+				is_pending[i] = true;
+				pending.push_back( i );
+			}
+		}
+	}
+	while ( !pending.empty() ) {
+		unsigned const i = pending.back();
+		pending.pop_back();
+		is_pending[i] = false;
+		if ( !this->vars[i]->IsAssigned() || propagated[i] ) continue;
+		Value const val = this->vars[i]->GetValue();
+		for ( unsigned j=0; j<n; ++j ) {
+			Variable* y = this->vars[j];
+			if ( y->IsAssigned() ) continue;
+			Value const d = static_cast<Value>(j) - static_cast<Value>(i);
+			if ( !this->Prune( y, val ) || !this->Prune( y, val+d ) || !this->Prune( y, val-d ) ) {
+				is_pending[i] = true;
+				pending.push_back( i );
+				return false;
+			}
+		}
+		propagated[i] = true;
+	}
+	//singletons left by propagation are not counted, their lines are
+	//pruned on every call
+	for ( unsigned i=0; i<n; ++i ) {
+		Variable* x = this->vars[i];
+		if ( x->IsAssigned() || x->SizeDomain() != 1 ) continue;
+		Value const val = x->GetMinValue();
+		for ( unsigned j=0; j<n; ++j ) {
+			Variable* y = this->vars[j];
+			if ( j == i || y->IsAssigned() ) continue;
+			Value const d = static_cast<Value>(j) - static_cast<Value>(i);
+			if ( !this->Prune( y, val ) || !this->Prune( y, val+d ) || !this->Prune( y, val-d ) ) return false;
+		}
+	}
+	return true;
+}
 #undef INLINE
 
 #endif
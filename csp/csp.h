@@ -10,46 +10,98 @@
 #include <utility>
 #include <algorithm>
 #include <limits>
+#include <cstdlib>
 #include <map>
+#include <stdint.h>
+#include "trail.h"
+#include "buckets.h"
+#include "propagation.h"
 
-template <typename C>
-struct Arc {
-	typedef typename C::Variable Variable;
-	//non-owning semantics, therefore DO NOT need big-4
-	Variable* x;
-	Variable* y;
-	const C* c;
-	Arc(Variable* x,Variable* y,const C* c) : x(x),y(y),c(c) {}
-	bool operator< (const Arc<C>& rhs) const {
-		if ( x<rhs.x) return true;
-		if ( x==rhs.x && y<rhs.y) return true;
-		if ( x==rhs.x && y==rhs.y && c<rhs.c) return true;
-
-		return false;
-	}
+////////////////////////////////////////////////////////////
+//asked by the solvers once per node whether to give up (the 
+//search returns false as if there was no solution), 
+//see CSP::SetInterrupt
+class Interrupt {
+	public:
+		virtual ~Interrupt() {}
+		virtual bool Requested() const = 0;
 };
 
+template <typename T> class ParallelSearch;
+template <typename T> struct Replica;
+
 template <typename T> 
 class CSP {
 		//typedef's for intenal use
 		typedef typename T::Constraint      Constraint;
 		typedef typename T::Variable        Variable;
 		typedef typename T::Variable::Value Value;
+		typedef typename T::Variable::Domain Domain;
+		typedef typename Domain::Word        Word;
 	public:
+		//how RemoveInconsistentValues looks for a support
+		enum ArcRevision {
+			AC3,    //scan the whole domain every time
+			AC3RM,  //first check the last support found (residue)
+			AC2001  //as AC3RM, then resume the scan from the residue
+		};
+		//how the next variable to assign is chosen
+		enum VariableOrdering {
+			MRV,        //minimum remaining values, lowest ID among ties
+			MRV_DEGREE, //minimum remaining values, max degree among ties
+			DOM_DEG,    //minimum ratio domain size / degree
+			DOM_WDEG,   //minimum ratio domain size / weighted degree
+			MAX_DEGREE  //maximum degree
+		};
+		//what the iterative search checks after each assignment
+		enum Consistency {
+			BACKTRACKING,     //constraints of the assigned variable, as SolveDFS
+			FORWARD_CHECKING, //as SolveFC
+			ARC_CONSISTENCY,  //as SolveARC
+			PROPAGATION       //to a fixpoint, as SolvePROP
+		};
+		//where Search stopped
+		enum SearchStatus {
+			SOLVED,    //all variables are assigned
+			EXHAUSTED, //no (more) solutions
+			PAUSED     //node limit reached or interrupted
+		};
 		////////////////////////////////////////////////////////////
 		//counters
 		////////////////////////////////////////////////////////////
-		//ctor
+		//ctor, attaches the trail to all variables of the graph and
+		//constraints to their variables (Constraint::Attach),
+		//the variables must not change after the CSP is destroyed
+		//(drivers delete them while the CSP is still in scope, so
+		//there is no dtor touching them)
 		CSP(T &cg);
 
 		//get the number of found solutions
-		int GetSolutionCounter() const { return solution_counter; }
+		uint64_t GetSolutionCounter() const { return solution_counter; }
 		//get the number of recursive calls - for debugging
 		int GetRecursiveCallCounter() const { return recursive_call_counter; }
 		//get the number of variable assigns in Solve* - for debugging
 		int GetIterationCounter() const { return iteration_counter; }
-
-		//CSP counting
+		//choose arc revision used by SolveARC (default AC2001)
+		void SetArcRevision(ArcRevision r) { arc_revision = r; }
+		//tabulate edges (y,x) whose constraints are all binary (and
+		//both domains BITSET): each value of y gets the bitset of its
+		//supports in x, so SolveARC revises the edge with a word-wise
+		//AND against the domain of x. Call before solving - values
+		//missing from the domains at this point are never supported
+		void CompileBinaryConstraints();
+		//choose variable ordering used by all solvers (default MRV)
+		void SetVariableOrdering(VariableOrdering o) { ordering = o; }
+		//forward checking (SolveFC, SolveARC) entails constraints that
+		//cannot fail any more, so they are skipped until the search
+		//backtracks past them (default off)
+		void SetEntailment(bool on) { entailment = on; }
+		//stop the solvers once "i" requests it (default none)
+		void SetInterrupt(const Interrupt* i) { interrupt = i; }
+
+		//CSP counting - forward checking through all solutions, 
+		//each one is added to GetSolutionCounter (the variables are
+		//left unassigned), returns true if there is some
 		bool SolveFC_count(unsigned level);
 		//CSP solver, brute force - no forward checking
 		bool SolveDFS(unsigned level);
@@ -57,45 +109,135 @@ class CSP {
 		bool SolveFC(unsigned level);
 		//CSP solver, uses arc consistency
 		bool SolveARC(unsigned level);
+		//CSP solver, propagates constraints to a fixpoint 
+		//(see propagation.h)
+		bool SolvePROP(unsigned level);
+
+		//iterative search - the solvers above without recursion, a
+		//decision stack holds a frame per assigned variable. Visits
+		//the nodes in the same order, so the counters are the same.
+		//StartSearch prepares a search from the current domains,
+		//Search runs it until it stops (see SearchStatus), with a
+		//limit of "max_nodes" nodes (0 - none), and is called again
+		//to resume - after SOLVED it looks for the next solution. 
+		//In between the variables hold the partial assignment
+		void StartSearch(Consistency c);
+		SearchStatus Search(uint64_t max_nodes = 0);
+		//decisions on the stack, the variable of each level
+		unsigned SearchDepth() const { return stack.size(); }
+		Variable* GetDecision(unsigned level) const { return cg.GetAllVariables()[ stack[level].var ]; }
+		//StartSearch and Search to the first solution
+		bool SolveIterative(Consistency c);
 	private:
-		//2 versions of forward checking algorithms
+		//parallel search branches above its split depth with the 
+		//private methods, replicas undo the search (see parallel.h)
+		friend class ParallelSearch<T>;
+		friend struct Replica<T>;
+		//some Interrupt was set and it requests to stop
+		bool Interrupted() const { return interrupt && interrupt->Requested(); }
+		//forward checking of the assigned variable x - its active 
+		//constraints prune the others, returns false if some domain
+		//becomes empty (with SetEntailment constraints that cannot 
+		//fail any more are entailed - ConstraintGraph::Entail)
 		bool ForwardChecking(Variable *x);
-		//load states (available values) of all unassigned variables 
-		void LoadState(std::map<Variable*, std::set<typename CSP<T>::Variable::Value> >& saved) 
-			//note: "CSP<T>::" in "std::set<typename CSP<T>::Variable::Value>" required for MSC
-		const ;
-		//save states (available values) of all unassigned variables 
-		//except the current
-		std::map<Variable*, std::set<typename Variable::Value> > 
-			SaveState(Variable* x) const;
 		//check the current (incomplete) assignment for satisfiability
 		bool AssignmentIsConsistent( Variable* p_var ) const;
+		//remove val from the domain of y if it is there, false if the
+		//domain becomes empty
+		static bool Prune(Variable* y, Value val);
 		//insert pair 
 		//(neighbors of the current variable, the current variable)
-		//for all y~x insert (y,x)
+		//for all unassigned y~x insert (y,x)
 		//into arc-consistency queue
 		void InsertAllArcsTo( Variable* cv );
 
-		//AIMA p.146 AC-3 algorithm
+		//AIMA p.146 AC-3 algorithm, starts with arcs into x
+		//returns false if some domain becomes empty
 		bool CheckArcConsistency(Variable* x);
-		//CHECK that for each value of x there is a value of y 
-		//which makes all constraints involving x and y satisfiable
-		bool RemoveInconsistentValues(Variable* x,Variable* y,const Constraint* c);
+		//CHECK that for each value of y there is a value of x 
+		//which makes all constraints involving x and y satisfiable,
+		//where (y,x) is the edge, remove values that fail
+		//returns true if something was removed
+		bool RemoveInconsistentValues(unsigned edge);
+		//same for a compiled edge
+		bool RemoveUnsupportedValues(unsigned edge);
+		//true if all constraints are satisfiable for the current assignment
+		static bool AllSatisfiable(const typename T::ConstraintRange& constr);
+		//check the assignment of x as "consistency" says
+		bool Consistent(Variable* x);
+		//choose next variable for assignment according to "ordering"
+		Variable* SelectVariable();
 		//choose next variable for assignment
 		//choose the one with minimum remaining values
 		Variable* MinRemVal();
 		//choose next variable for assignment
+		//minimum remaining values, ties broken by max degree
+		Variable* MinRemValMaxDegree();
+		//choose next variable for assignment
+		//minimum ratio of domain size and (weighted) degree
+		Variable* MinDomOverDegree(bool weighted);
+		//number (total weight) of constraints on the variable which
+		//involve some other unassigned variable
+		unsigned Degree(Variable* x, bool weighted) const;
+		//re-file variables whose domains changed since the checkpoint
+		void UpdateBuckets(unsigned checkpoint);
+		//undo the trail to the checkpoint, re-file restored variables,
+		//activate constraints entailed since ConstraintGraph::NumEntailed
+		//returned "entailed"
+		void Backtrack(unsigned checkpoint, unsigned entailed);
+		//choose next variable for assignment
 		//choose the one with max degree
 		Variable* MaxDegreeHeuristic();
 
-		// deep cp dom for mod'ing orig dom
-		std::set<typename Variable::Value>* CpDomFromVar(Variable* var);
-
 		//data
-		//deque of arcs (2 Variables connected through a Constraint)
-		std::set< Arc<Constraint> > arc_consistency;
 		T &cg;
-		int solution_counter,recursive_call_counter,iteration_counter;
+		//log of removed values, undone on backtracking
+		Trail trail;
+		//unassigned variables by domain size, filled when a solver
+		//is entered at level 0
+		DomainBuckets buckets;
+		//scratch for Backtrack
+		std::vector<Variable*> touched;
+		//event driven propagation for SolvePROP
+		Scheduler<T> scheduler;
+		//variable ordering and scratch for MinRemValMaxDegree
+		VariableOrdering ordering;
+		std::vector<Variable*> candidates;
+		bool entailment;
+		const Interrupt* interrupt;
+		//arc-consistency queue - FIFO ring of edges (an edge (y,x) 
+		//means "revise y against x"), "in_queue" marks queued edges,
+		//so there are no duplicates and NumEdges slots are enough
+		std::vector<unsigned> arc_queue;
+		std::vector<bool> in_queue;
+		unsigned queue_head,queue_size;
+		//scratch for RemoveInconsistentValues
+		std::vector<Value> inconsistent_values;
+		//last support found for each (edge (y,x), value of y): a value
+		//of x stored at residues[ residue_offsets[edge] + index of value ]
+		//(index is Domain::IndexOf), only a hint - checked before use
+		ArcRevision arc_revision;
+		std::vector<unsigned> residue_offsets;
+		std::vector<Value> residues;
+		//compiled edges: row of value y of edge (y,x) is at
+		//supports[ support_offsets[edge] + index of y * words of x ],
+		//NoEdge() if the edge is not compiled
+		std::vector<unsigned> support_offsets;
+		std::vector<Word> supports;
+		//decision stack of the iterative search: the variable, its 
+		//value being tried and the state to backtrack to. "descend"
+		//if the next node is still to be opened
+		struct Frame {
+			unsigned var;
+			typename Domain::const_iterator value;
+			unsigned checkpoint;
+			unsigned entailed;
+		};
+		std::vector<Frame> stack;
+		Consistency consistency;
+		bool descend;
+		uint64_t solution_counter;
+		int recursive_call_counter,iteration_counter;
 };
 
 #ifdef INLINE_CSP
@@ -110,17 +252,103 @@ class CSP {
 //CSP constructor
 template <typename T> 
 CSP<T>::CSP(T &cg) :
-	arc_consistency(),
 	cg(cg),
+	trail(),
+	buckets(),
+	touched(),
+	scheduler(cg,trail),
+	ordering(MRV),
+	candidates(),
+	entailment(false),
+	interrupt(0),
+	arc_queue(),
+	in_queue(),
+	queue_head(0),
+	queue_size(0),
+	inconsistent_values(),
+	arc_revision(AC2001),
+	residue_offsets(),
+	residues(),
+	support_offsets(),
+	supports(),
+	stack(),
+	consistency(FORWARD_CHECKING),
+	descend(false),
 	solution_counter(0),
 	recursive_call_counter(0),
 	iteration_counter(0) 
 {
+	const std::vector<Variable*>& all_vars = cg.GetAllVariables();
+	typename std::vector<Variable*>::const_iterator 
+		b_all_vars = all_vars.begin();
+	typename std::vector<Variable*>::const_iterator 
+		e_all_vars = all_vars.end();
+	for ( ; b_all_vars!=e_all_vars; ++b_all_vars) {
+		(*b_all_vars)->SetTrail( &trail );
+	}
+	for ( unsigned c=0; c<cg.NumConstraints(); ++c ) {
+		cg.GetConstraint(c)->Attach();
+	}
 }
 
+////////////////////////////////////////////////////////////
+//CSP counting, as SolveFC but every solution is counted and the
+//search goes on
 template<typename T>
 bool CSP<T>::SolveFC_count(unsigned level) {
-	return false;
+  ++recursive_call_counter;
+
+  // asked to give up (see SetInterrupt)
+  if (Interrupted())
+    return false;
+
+  // file variables by domain size
+  if (level == 0)
+    buckets.Init(cg.GetAllVariables());
+
+  // all assigned, count and look for the next one
+  if (buckets.NumUnassigned() == 0) {
+    ++solution_counter;
+    return true;
+  }
+
+  // get next var to assign
+  Variable* var_to_assign = SelectVariable();
+  buckets.Remove(var_to_assign);
+
+  // remember trail position and entailed constraints
+  unsigned const checkpoint = trail.Checkpoint();
+  unsigned const entailed = cg.NumEntailed();
+
+  // for each val in domain, count below it
+  bool hasSolution = false;
+  Domain const& domain
+    = var_to_assign->GetDomain();
+  for (
+    typename Domain::const_iterator domItr
+    = domain.begin();
+    domItr != domain.end();
+    ++domItr
+    ) {
+
+    ++iteration_counter;
+
+    var_to_assign->Assign(*domItr);
+    if (ForwardChecking(var_to_assign)) {
+      UpdateBuckets(checkpoint);
+      if (SolveFC_count(level + 1))
+        hasSolution = true;
+    }
+
+    // unassign and undo pruning
+    var_to_assign->UnAssign();
+    Backtrack(checkpoint, entailed);
+    // the level below gave up, so does this one
+    if (Interrupted())
+      break;
+  }
+  buckets.Insert(var_to_assign);
+  return hasSolution;
 }
 
 ////////////////////////////////////////////////////////////
@@ -136,21 +364,30 @@ bool CSP<T>::SolveDFS(unsigned level) {
   if (isDebugOn)
     std::cout << "entering SolveDFS (level " << level << ")\n";
 
+  // asked to give up (see SetInterrupt)
+  if (Interrupted())
+    return false;
+
+  // file variables by domain size
+  if (level == 0)
+    buckets.Init(cg.GetAllVariables());
+
   // true ending
-  if (cg.AllVariablesAssigned()) {
+  if (buckets.NumUnassigned() == 0) {
     if (isDebugOn)
       std::cout << "exiting SolveDFS (level " << level << ")\n";
     return true;
   }
 
-  Variable* var_to_assign = MinRemVal();
+  Variable* var_to_assign = SelectVariable();
+  buckets.Remove(var_to_assign);
 
   // get var w/ mrv
-  std::set<typename Variable::Value> const& domain = var_to_assign->GetDomain();
+  Domain const& domain = var_to_assign->GetDomain();
 
 	// for each val in domain
   for (
-    typename std::set<typename Variable::Value>::const_iterator i
+    typename Domain::const_iterator i
     = domain.begin();
     i != domain.end();
     ++i
@@ -164,19 +401,10 @@ bool CSP<T>::SolveDFS(unsigned level) {
 			std::cout << "trying assigning, "
 			<< var_to_assign->Name() << ": " << *i << "\n";
 
-		bool isSatisfied = true;
-
-
 		//  for each constraint c such that v is a variable of c
 		//            and all other variables of c
 		//            are assigned.
-		for (auto& constr : cg.GetConstraints(var_to_assign)) {
-			// check every constr's are satisfied
-			if (not constr->Satisfiable()) {
-				isSatisfied = false;
-				break;
-			}
-    }
+		bool const isSatisfied = AssignmentIsConsistent(var_to_assign);
 
     // if satis'ed, rec to nxt lvl
 		if (isSatisfied) {
@@ -194,7 +422,11 @@ bool CSP<T>::SolveDFS(unsigned level) {
       << var_to_assign->Name() << ": "
       << var_to_assign->GetValue() << "\n" << "\n";
     var_to_assign->UnAssign();
+    // the level below gave up, so does this one
+    if (Interrupted())
+      break;
   }
+  buckets.Insert(var_to_assign);
 
   if (isDebugOn)
     std::cout << "exiting SolveDFS (level " << level << ")\n";
@@ -214,26 +446,35 @@ bool CSP<T>::SolveFC(unsigned level) {
   if (isDebugOn)
     std::cout << "entering SolveFC (level " << level << ")\n";
 
+  // asked to give up (see SetInterrupt)
+  if (Interrupted())
+    return false;
+
+  // file variables by domain size
+  if (level == 0)
+    buckets.Init(cg.GetAllVariables());
+
   // true ending
-  if (cg.AllVariablesAssigned()) {
+  if (buckets.NumUnassigned() == 0) {
     if (isDebugOn)
       std::cout << "exiting SolveFC (level " << level << ")\n";
     return true;
   }
 
   // get next var to assign
-  Variable* var_to_assign = MinRemVal();
+  Variable* var_to_assign = SelectVariable();
+  buckets.Remove(var_to_assign);
 
-  // save state of all unassigned var's except curr
-  std::map<
-    typename CSP<T>::Variable*, std::set<typename CSP<T>::Variable::Value>
-  > savedState = SaveState(var_to_assign);
+  // remember trail position, everything pruned below is undone to it,
+  // and the entailed constraints, activated again
+  unsigned const checkpoint = trail.Checkpoint();
+  unsigned const entailed = cg.NumEntailed();
 
   // for each val in domain
-  std::set<typename Variable::Value> const& domain1
+  Domain const& domain1
     = var_to_assign->GetDomain();
   for (
-    typename std::set<typename Variable::Value>::const_iterator domItr1
+    typename Domain::const_iterator domItr1
     = domain1.begin();
     domItr1 != domain1.end();
     ++domItr1
@@ -249,67 +490,18 @@ bool CSP<T>::SolveFC(unsigned level) {
       << var_to_assign->Name() << ": " << *domItr1 << "\n";
     var_to_assign->Assign(*domItr1);
 
-    // for each neighboring var's
-    std::set<Variable*> const& neighbors = cg.GetNeighbors(var_to_assign);
-    for (
-      typename std::set<Variable*>::const_iterator neiItr = neighbors.begin();
-      neiItr != neighbors.end();
-      ++neiItr
-      ) {
-
-      // skip assigned var's
-      if ((*neiItr)->IsAssigned())
-        continue;
-
-      // for each val in domain of neighbor
-      std::set<typename Variable::Value> const* const domain2
-				= CpDomFromVar(*neiItr);
-      for (
-        typename std::set<typename Variable::Value>::const_iterator domItr2
-        = domain2->begin();
-        domItr2 != domain2->end();
-        ++domItr2
-        ) {
-
-        // assign neighbor to test constr's
-        (*neiItr)->Assign(*domItr2);
-
-        // for each connected constr
-        const std::set<const Constraint*>& constr
-          = cg.GetConnectingConstraints(var_to_assign, *neiItr);
-        for (
-          typename std::set<const Constraint*>::const_iterator constrItr
-          = constr.begin();
-          constrItr != constr.end();
-          ++constrItr
-          ) {
-
-          if (not (*constrItr)->Satisfiable()) {
-            // non-satis cond, rm val from dom
-            if (isDebugOn)
-              std::cout << "  unsatisfied, rm'ing val from neighbor "
-              << (*neiItr)->Name() << ": " << *domItr2 << "\n";
-            (*neiItr)->RemoveValue(*domItr2);
-            break;
-          }
-        }
-
-        // val tested, so unassign
-        (*neiItr)->UnAssign();
-      }
-
-			delete domain2;
-
-			// var w/o domain, no possible future
-      if ((*neiItr)->IsImpossible()) {
-				// has no future w/ val assignment
-				hasPossibleFuture = false;
-        break;
-      }
+    // each constr on the var prunes unassigned var's sharing it,
+    // the one wiping out a domain is blamed for it (dom/wdeg)
+    if (not ForwardChecking(var_to_assign)) {
+      // var w/o domain, no possible future
+      if (isDebugOn)
+        std::cout << "  domain wiped out\n";
+      hasPossibleFuture = false;
     }
 
     // if assignment has possible future, rec to nxt lvl
     if (hasPossibleFuture) {
+      UpdateBuckets(checkpoint);
       if (isDebugOn)
         std::cout << "    has possible future, to nxt lvl w/ "
         << var_to_assign->Name() << ": " << var_to_assign->GetValue()
@@ -327,9 +519,13 @@ bool CSP<T>::SolveFC(unsigned level) {
         << var_to_assign->GetValue() << "\n" << "\n";
     }
     var_to_assign->UnAssign();
-    // load state and break out to try diff var to assign
-    LoadState(savedState);
+    // undo pruning and break out to try diff var to assign
+    Backtrack(checkpoint, entailed);
+    // the level below gave up, so does this one
+    if (Interrupted())
+      break;
   }
+  buckets.Insert(var_to_assign);
 
   // bad ending
   if (isDebugOn)
@@ -338,228 +534,714 @@ bool CSP<T>::SolveFC(unsigned level) {
 }
 ////////////////////////////////////////////////////////////
 //CSP solver, uses arc consistency
+//(maintains arc consistency after each assignment)
 template <typename T> 
 bool CSP<T>::SolveARC(unsigned level) {
+  // debugging purpose
+  bool const isDebugOn = false;
 
-	// TODO: place holder
-	(void)level;
-	return false;
-
-}
+  // update rec call ct
+  ++recursive_call_counter;
 
+  if (isDebugOn)
+    std::cout << "entering SolveARC (level " << level << ")\n";
 
-template <typename T> 
-INLINE
-bool CSP<T>::ForwardChecking(Variable *x) {
+  // asked to give up (see SetInterrupt)
+  if (Interrupted())
+    return false;
 
-	// todo: place holder
-	return false;
+  // file variables by domain size
+  if (level == 0)
+    buckets.Init(cg.GetAllVariables());
 
+  // true ending
+  if (buckets.NumUnassigned() == 0) {
+    if (isDebugOn)
+      std::cout << "exiting SolveARC (level " << level << ")\n";
+    return true;
+  }
 
+  // get next var to assign
+  Variable* var_to_assign = SelectVariable();
+  buckets.Remove(var_to_assign);
 
+  // remember trail position, everything pruned below is undone to it,
+  // and the entailed constraints, activated again
+  unsigned const checkpoint = trail.Checkpoint();
+  unsigned const entailed = cg.NumEntailed();
 
+  // for each val in domain
+  // (only unassigned variables are pruned, so domain is not modified)
+  Domain const& domain
+    = var_to_assign->GetDomain();
+  for (
+    typename Domain::const_iterator domItr
+    = domain.begin();
+    domItr != domain.end();
+    ++domItr
+    ) {
 
+    ++iteration_counter;
 
-}
-////////////////////////////////////////////////////////////
-//load states (available values) of all unassigned variables 
-template <typename T> 
-void CSP<T>::LoadState(
-		std::map<Variable*, 
-		std::set<typename CSP<T>::Variable::Value> >& saved) const 
-{
-	typename std::map<Variable*, std::set<typename Variable::Value> >::iterator 
-		b_result = saved.begin();
-	typename std::map<Variable*, std::set<typename Variable::Value> >::iterator 
-		e_result = saved.end();
-
-	for ( ; b_result != e_result; ++b_result ) {
-		//std::cout << "loading state for " /cg
-		//<< b_result->first->Name() << std::endl;
-		(*b_result).first->SetDomain( (*b_result).second );
-	}
-}
+    if (isDebugOn)
+      std::cout << "trying assigning, "
+      << var_to_assign->Name() << ": " << *domItr << "\n";
+    var_to_assign->Assign(*domItr);
 
+    // propagate, rec to nxt lvl if no domain wiped out
+    if (CheckArcConsistency(var_to_assign)) {
+      UpdateBuckets(checkpoint);
+      if (SolveARC(level + 1))
+        return true;
+    }
+    else if (isDebugOn)
+      std::cout << "  arc consistency wiped out a domain\n";
 
-////////////////////////////////////////////////////////////
-//save states (available values) of all unassigned variables 
-//except the current
-template <typename T> 
-INLINE
-std::map< typename CSP<T>::Variable*, std::set<typename CSP<T>::Variable::Value> > 
-CSP<T>::SaveState(typename CSP<T>::Variable* x) const {
-	std::map<Variable*, std::set<typename Variable::Value> > result;
+    // unassign and undo pruning
+    var_to_assign->UnAssign();
+    Backtrack(checkpoint, entailed);
+    // the level below gave up, so does this one
+    if (Interrupted())
+      break;
+  }
+  buckets.Insert(var_to_assign);
 
-	const std::vector<Variable*>& all_vars = cg.GetAllVariables();
-	typename std::vector<Variable*>::const_iterator 
-		b_all_vars = all_vars.begin();
-	typename std::vector<Variable*>::const_iterator 
-		e_all_vars = all_vars.end();
-	for ( ; b_all_vars!=e_all_vars; ++b_all_vars) {
-		if ( !(*b_all_vars)->IsAssigned() && *b_all_vars!=x ) {
-			//std::cout << "saving state for " 
-			//<< (*b_all_vars)->Name() << std::endl;
-			result[ *b_all_vars ] = (*b_all_vars)->GetDomain();
-		}
-	}
-	return result;
+  // bad ending
+  if (isDebugOn)
+    std::cout << "exiting SolveARC (level " << level << ")\n";
+  return false;
 }
 ////////////////////////////////////////////////////////////
-//check the current (incomplete) assignment for satisfiability
+//CSP solver, propagates constraints to a fixpoint after each
+//assignment
 template <typename T> 
-INLINE
-bool CSP<T>::AssignmentIsConsistent( Variable* p_var ) const {
+bool CSP<T>::SolvePROP(unsigned level) {
+  // debugging purpose
+  bool const isDebugOn = false;
 
-	// todo: place holder
-	return false;
+  // update rec call ct
+  ++recursive_call_counter;
 
+  if (isDebugOn)
+    std::cout << "entering SolvePROP (level " << level << ")\n";
 
+  // asked to give up (see SetInterrupt)
+  if (Interrupted())
+    return false;
 
+  // file variables by domain size
+  if (level == 0)
+    buckets.Init(cg.GetAllVariables());
 
+  // true ending
+  if (buckets.NumUnassigned() == 0) {
+    if (isDebugOn)
+      std::cout << "exiting SolvePROP (level " << level << ")\n";
+    return true;
+  }
 
+  // get next var to assign
+  Variable* var_to_assign = SelectVariable();
+  buckets.Remove(var_to_assign);
 
+  // remember trail position, everything pruned below is undone to it,
+  // and the entailed constraints, activated again
+  unsigned const checkpoint = trail.Checkpoint();
+  unsigned const entailed = cg.NumEntailed();
 
+  // for each val in domain
+  // (only unassigned variables are pruned, so domain is not modified)
+  Domain const& domain
+    = var_to_assign->GetDomain();
+  for (
+    typename Domain::const_iterator domItr
+    = domain.begin();
+    domItr != domain.end();
+    ++domItr
+    ) {
 
+    ++iteration_counter;
 
+    if (isDebugOn)
+      std::cout << "trying assigning, "
+      << var_to_assign->Name() << ": " << *domItr << "\n";
+    var_to_assign->Assign(*domItr);
 
+    // propagate, rec to nxt lvl if no domain wiped out
+    if (scheduler.Propagate(var_to_assign)) {
+      UpdateBuckets(checkpoint);
+      if (SolvePROP(level + 1))
+        return true;
+    }
+    else if (isDebugOn)
+      std::cout << "  propagation wiped out a domain\n";
 
+    // unassign and undo pruning
+    var_to_assign->UnAssign();
+    Backtrack(checkpoint, entailed);
+    // the level below gave up, so does this one
+    if (Interrupted())
+      break;
+  }
+  buckets.Insert(var_to_assign);
 
+  // bad ending
+  if (isDebugOn)
+    std::cout << "exiting SolvePROP (level " << level << ")\n";
+  return false;
 }
+
 ////////////////////////////////////////////////////////////
-//insert pair 
-//(neighbors of the current variable, the current variable)
-//current variable is th variable that just lost some values
-// for all y~x insert (y,x)
-//into arc-consistency queue
+//iterative search from the current domains
 template <typename T> 
-INLINE
-void CSP<T>::InsertAllArcsTo( Variable* cv ) {
-
-
-
-
+void CSP<T>::StartSearch(Consistency c) {
+  consistency = c;
+  buckets.Init(cg.GetAllVariables());
+  stack.clear();
+  stack.reserve(buckets.NumUnassigned());
+  descend = true;
+}
 
+////////////////////////////////////////////////////////////
+//a node is opened as the solvers enter a level: a variable is 
+//selected and gets a frame. The top frame then tries its values,
+//an assignment that passes the check opens the next node, a frame 
+//out of values is popped - back to the level above. A variable is
+//assigned exactly while its value is tried or searched below
+template <typename T> 
+typename CSP<T>::SearchStatus CSP<T>::Search(uint64_t max_nodes) {
+  const std::vector<Variable*>& all_vars = cg.GetAllVariables();
+  bool const undo = consistency != BACKTRACKING;
+  uint64_t nodes = 0;
+  for (;;) {
+    // asked to give up (see SetInterrupt), Search resumes from here
+    if (Interrupted())
+      return PAUSED;
+
+    if (descend) {
+      if (max_nodes && nodes == max_nodes)
+        return PAUSED;
+      ++nodes;
+      ++recursive_call_counter;
+      // all assigned, the next call backtracks from here
+      if (buckets.NumUnassigned() == 0) {
+        descend = false;
+        return SOLVED;
+      }
+      Variable* var_to_assign = SelectVariable();
+      buckets.Remove(var_to_assign);
+      Frame const frame = { var_to_assign->ID(), var_to_assign->GetDomain().begin(),
+        trail.Checkpoint(), cg.NumEntailed() };
+      stack.push_back(frame);
+      descend = false;
+    }
 
+    if (stack.empty())
+      return EXHAUSTED;
+    Frame& frame = stack.back();
+    Variable* var_to_assign = all_vars[frame.var];
+
+    // back from the value tried last, unassign and undo pruning
+    // (the domain of an unassigned variable is pruned by nobody
+    // else, so the iterator stays valid)
+    if (var_to_assign->IsAssigned()) {
+      var_to_assign->UnAssign();
+      if (undo)
+        Backtrack(frame.checkpoint, frame.entailed);
+      ++frame.value;
+    }
 
+    // out of values, back to the level above
+    if (frame.value == var_to_assign->GetDomain().end()) {
+      buckets.Insert(var_to_assign);
+      stack.pop_back();
+      continue;
+    }
 
+    ++iteration_counter;
+    var_to_assign->Assign(*frame.value);
+    if (Consistent(var_to_assign)) {
+      if (undo)
+        UpdateBuckets(frame.checkpoint);
+      descend = true;
+    }
+  }
+}
 
+////////////////////////////////////////////////////////////
+template <typename T> 
+bool CSP<T>::SolveIterative(Consistency c) {
+  StartSearch(c);
+  return Search() == SOLVED;
+}
 
+////////////////////////////////////////////////////////////
+template <typename T> 
+INLINE
+bool CSP<T>::Consistent(Variable* x) {
+  switch (consistency) {
+    case BACKTRACKING:     return AssignmentIsConsistent(x);
+    case FORWARD_CHECKING: return ForwardChecking(x);
+    case ARC_CONSISTENCY:  return CheckArcConsistency(x);
+    default:               return scheduler.Propagate(x);
+  }
+}
 
+////////////////////////////////////////////////////////////
+//constraints of the assigned variable x prune the other variables,
+//the one wiping out a domain is blamed for it (dom/wdeg). Batched
+//AllDiff2/DifferenceNotEqual are done in place, without virtual calls
+//and are not entailed
+template <typename T> 
+INLINE
+bool CSP<T>::ForwardChecking(Variable *x) {
+	typename T::ConstraintRange constr;
+	if ( cg.IsBatched() ) {
+		Value const val = x->GetValue();
+		typename T::NotEqualBatch const not_equal = cg.GetNotEqual(x);
+		typename T::NotEqualBatch::const_iterator b_n = not_equal.begin();
+		typename T::NotEqualBatch::const_iterator e_n = not_equal.end();
+		for ( ; b_n!=e_n; ++b_n ) {
+			Variable* y = b_n->other;
+			bool const ok = y->IsAssigned() ? y->GetValue() != val : Prune( y, val );
+			if ( !ok ) {
+				cg.IncrementWeight( b_n->id );
+				return false;
+			}
+		}
+		typename T::DiffNotEqualBatch const diff = cg.GetDiffNotEqual(x);
+		typename T::DiffNotEqualBatch::const_iterator b_d = diff.begin();
+		typename T::DiffNotEqualBatch::const_iterator e_d = diff.end();
+		for ( ; b_d!=e_d; ++b_d ) {
+			Variable* y = b_d->other;
+			bool const ok = y->IsAssigned() ? 
+				std::abs( y->GetValue() - val ) != b_d->constant :
+				Prune( y, val + b_d->constant ) && Prune( y, val - b_d->constant );
+			if ( !ok ) {
+				cg.IncrementWeight( b_d->id );
+				return false;
+			}
+		}
+		constr = cg.GetOtherConstraints(x);
+	} else {
+		constr = cg.GetActiveConstraints(x);
+	}
+	typename T::ConstraintRange::const_iterator b_c = constr.begin();
+	typename T::ConstraintRange::const_iterator e_c = constr.end();
+	for ( ; b_c!=e_c; ++b_c ) {
+		if ( cg.IsBatched() && cg.IsEntailed( b_c.ID() ) ) continue;
+		if ( ! (*b_c)->Propagate() ) {
+			cg.IncrementWeight( b_c.ID() );
+			return false;
+		}
+		//(twice in the row if it uses x twice)
+		if ( entailment && ! cg.IsEntailed( b_c.ID() ) && (*b_c)->Entailed() ) {
+			cg.Entail( b_c.ID() );
+		}
+	}
+	return true;
 }
 ////////////////////////////////////////////////////////////
-
+//check the current (incomplete) assignment for satisfiability:
+//all active constraints of the assigned variable p_var
+template <typename T> 
+INLINE
+bool CSP<T>::AssignmentIsConsistent( Variable* p_var ) const {
+	if ( !cg.IsBatched() ) return AllSatisfiable( cg.GetActiveConstraints(p_var) );
+	Value const val = p_var->GetValue();
+	typename T::NotEqualBatch const not_equal = cg.GetNotEqual(p_var);
+	typename T::NotEqualBatch::const_iterator b_n = not_equal.begin();
+	typename T::NotEqualBatch::const_iterator e_n = not_equal.end();
+	for ( ; b_n!=e_n; ++b_n ) {
+		if ( b_n->other->IsAssigned() && b_n->other->GetValue() == val ) return false;
+	}
+	typename T::DiffNotEqualBatch const diff = cg.GetDiffNotEqual(p_var);
+	typename T::DiffNotEqualBatch::const_iterator b_d = diff.begin();
+	typename T::DiffNotEqualBatch::const_iterator e_d = diff.end();
+	for ( ; b_d!=e_d; ++b_d ) {
+		if ( b_d->other->IsAssigned() && 
+				std::abs( b_d->other->GetValue() - val ) == b_d->constant ) return false;
+	}
+	return AllSatisfiable( cg.GetOtherConstraints(p_var) );
+}
+////////////////////////////////////////////////////////////
+//remove the value from the domain if it is there, 
+//returns false if the domain becomes empty
+template <typename T> 
+INLINE
+bool CSP<T>::Prune(Variable* y, Value val) {
+	if ( y->GetDomain().Contains(val) ) y->RemoveValue(val);
+	return !y->IsImpossible();
+}
+////////////////////////////////////////////////////////////
+//insert pair 
+//(neighbors of the current variable, the current variable)
+//current variable is th variable that just lost some values
+// for all unassigned y~x insert (y,x)
+//into arc-consistency queue
+template <typename T> 
+INLINE
+void CSP<T>::InsertAllArcsTo( Variable* cv ) {
+	typename T::VariableRange const neighbors = cg.GetNeighbors(cv);
+	unsigned edge = cg.GetFirstEdge(cv);
+	typename T::VariableRange::const_iterator b_n = neighbors.begin();
+	typename T::VariableRange::const_iterator e_n = neighbors.end();
+	for ( ; b_n!=e_n; ++b_n, ++edge ) {
+		if ( (*b_n)->IsAssigned() ) continue;
+		unsigned arc = cg.GetReverseEdge(edge);
+		if ( in_queue[arc] ) continue;
+		in_queue[arc] = true;
+		unsigned tail = queue_head + queue_size++;
+		if ( tail >= arc_queue.size() ) tail -= arc_queue.size();
+		arc_queue[tail] = arc;
+	}
+}
 ////////////////////////////////////////////////////////////
 //AIMA p.146 AC-3 algorithm
 template <typename T> 
 INLINE
 bool CSP<T>::CheckArcConsistency(Variable* x) {
+	if ( arc_queue.size() != cg.NumEdges() ) {
+		arc_queue.assign( cg.NumEdges(), 0 );
+		in_queue.assign( cg.NumEdges(), false );
+		residue_offsets.assign( 1, 0 );
+		for ( unsigned e=0; e<cg.NumEdges(); ++e ) {
+			residue_offsets.push_back( residue_offsets.back() + 
+					cg.GetEdgeSource(e)->GetDomain().Universe() );
+		}
+		residues.assign( residue_offsets.back(), std::numeric_limits<Value>::min() );
+	}
+	queue_head = 0;
+	queue_size = 0;
+
+	//arcs into x (x is assigned) - revising them is what the 
+	//constraints on x do in Propagate
+	unsigned const checkpoint = trail.Checkpoint();
+	if ( ! ForwardChecking(x) ) return false;
+	//continue from variables that lost values
+	for ( unsigned i=checkpoint; i<trail.Checkpoint(); ++i ) {
+		InsertAllArcsTo( trail.GetVariable(i) );
+	}
 
-	// todo: place holder
-	return false;
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+	while ( queue_size ) {
+		unsigned arc = arc_queue[queue_head];
+		if ( ++queue_head == arc_queue.size() ) queue_head = 0;
+		--queue_size;
+		in_queue[arc] = false;
+
+		Variable* y = cg.GetEdgeSource(arc);
+		if ( y->IsAssigned() ) continue;
+		if ( RemoveInconsistentValues(arc) ) {
+			if ( y->IsImpossible() ) {
+				//all constraints of the arc are blamed (dom/wdeg)
+				typename T::ConstraintRange const constr = cg.GetEdgeConstraints(arc);
+				typename T::ConstraintRange::const_iterator b_c = constr.begin();
+				typename T::ConstraintRange::const_iterator e_c = constr.end();
+				for ( ; b_c!=e_c; ++b_c ) {
+					cg.IncrementWeight( b_c.ID() );
+				}
+				//empty the queue for the next call
+				for ( ; queue_size; --queue_size ) {
+					in_queue[ arc_queue[queue_head] ] = false;
+					if ( ++queue_head == arc_queue.size() ) queue_head = 0;
+				}
+				return false;
+			}
+			InsertAllArcsTo( y );
+		}
+	}
+	return true;
 }
 ////////////////////////////////////////////////////////////
-//CHECK that for each value of x there is a value of y 
+//CHECK that for each value of y there is a value of x 
 //which makes all constraints involving x and y satisfiable
+//with AC3RM/AC2001 the residue of the value is tried first,
+//AC2001 then scans from the residue to the end and wraps around
+//(only BITSET and SET domains are ordered, SPARSE scans from the start)
 template <typename T> 
 INLINE
-bool CSP<T>::RemoveInconsistentValues(Variable* x,Variable* y,const Constraint* c) {
-
-	// todo: place holder
-	return false;
-
-
-
-
-
-
-
-
-
-
-
-
+bool CSP<T>::RemoveInconsistentValues(unsigned edge) {
+	if ( edge < support_offsets.size() && support_offsets[edge] != T::NoEdge() ) {
+		return RemoveUnsupportedValues(edge);
+	}
+	Variable* y = cg.GetEdgeSource(edge);
+	Variable* x = cg.GetEdgeTarget(edge);
+	typename T::ConstraintRange const constr = cg.GetEdgeConstraints(edge);
+	bool const x_assigned = x->IsAssigned();
+	unsigned const residue_base = residue_offsets[edge];
+	unsigned const residue_count = residue_offsets[edge+1] - residue_base;
+
+	//values are removed after the scan - removal may reorder the domain
+	inconsistent_values.clear();
+	Domain const& dom_y = y->GetDomain();
+	Domain const& dom_x = x->GetDomain();
+	typename Domain::const_iterator b_y = dom_y.begin();
+	typename Domain::const_iterator e_y = dom_y.end();
+	for ( ; b_y!=e_y; ++b_y ) {
+		y->Assign(*b_y);
+		bool supported = false;
+		if ( x_assigned ) {
+			supported = AllSatisfiable(constr);
+		} else {
+			Value* residue = 0;
+			if ( arc_revision != AC3 ) {
+				int index = dom_y.IndexOf(*b_y);
+				if ( index >= 0 && static_cast<unsigned>(index) < residue_count ) {
+					residue = &residues[ residue_base + index ];
+				}
+			}
+			bool residue_checked = false;
+			if ( residue && dom_x.Contains(*residue) ) {
+				x->Assign(*residue);
+				supported = AllSatisfiable(constr);
+				residue_checked = true;
+			}
+			if ( !supported ) {
+				typename Domain::const_iterator start = 
+					( residue && arc_revision == AC2001 ) ? 
+					dom_x.lower_bound(*residue) : dom_x.begin();
+				typename Domain::const_iterator e_x = dom_x.end();
+				//[start,end) then [begin,start)
+				for ( int pass=0; pass<2 && !supported; ++pass ) {
+					typename Domain::const_iterator b_x = pass ? dom_x.begin() : start;
+					if ( pass ) e_x = start;
+					for ( ; b_x!=e_x; ++b_x ) {
+						if ( residue_checked && *b_x == *residue ) continue;
+						x->Assign(*b_x);
+						if ( AllSatisfiable(constr) ) {
+							supported = true;
+							if ( residue ) *residue = *b_x;
+							break;
+						}
+					}
+				}
+			}
+			x->UnAssign();
+		}
+		y->UnAssign();
+		if ( !supported ) inconsistent_values.push_back(*b_y);
+	}
 
+	typename std::vector<Value>::const_iterator b_v = inconsistent_values.begin();
+	typename std::vector<Value>::const_iterator e_v = inconsistent_values.end();
+	for ( ; b_v!=e_v; ++b_v ) {
+		y->RemoveValue(*b_v);
+	}
+	return !inconsistent_values.empty();
+}
+////////////////////////////////////////////////////////////
+//a value of y is supported if its row intersects the domain of x
+//(or has the bit of the value of x)
+template <typename T> 
+INLINE
+bool CSP<T>::RemoveUnsupportedValues(unsigned edge) {
+	Variable* y = cg.GetEdgeSource(edge);
+	Variable* x = cg.GetEdgeTarget(edge);
+	Domain const& dom_y = y->GetDomain();
+	Domain const& dom_x = x->GetDomain();
+	unsigned const num_words = dom_x.NumWords();
+	const Word* table = &supports[ support_offsets[edge] ];
+	int const x_index = x->IsAssigned() ? dom_x.IndexOf( x->GetValue() ) : -1;
+
+	inconsistent_values.clear();
+	typename Domain::const_iterator b_y = dom_y.begin();
+	typename Domain::const_iterator e_y = dom_y.end();
+	for ( ; b_y!=e_y; ++b_y ) {
+		const Word* row = table + dom_y.IndexOf(*b_y) * num_words;
+		bool supported = x_index >= 0 ?
+			( row[ x_index / Domain::BITS ] >> ( x_index % Domain::BITS ) ) & 1 :
+			Domain::Intersects( row, dom_x.Words(), num_words );
+		if ( !supported ) inconsistent_values.push_back(*b_y);
+	}
 
+	typename std::vector<Value>::const_iterator b_v = inconsistent_values.begin();
+	typename std::vector<Value>::const_iterator e_v = inconsistent_values.end();
+	for ( ; b_v!=e_v; ++b_v ) {
+		y->RemoveValue(*b_v);
+	}
+	return !inconsistent_values.empty();
+}
+////////////////////////////////////////////////////////////
+template <typename T> 
+void CSP<T>::CompileBinaryConstraints() {
+	support_offsets.assign( cg.NumEdges(), T::NoEdge() );
+	supports.clear();
+	std::vector<Word> row;
+	for ( unsigned e=0; e<cg.NumEdges(); ++e ) {
+		Variable* y = cg.GetEdgeSource(e);
+		Domain const& dom_y = y->GetDomain();
+		Domain const& dom_x = cg.GetEdgeTarget(e)->GetDomain();
+		if ( !dom_y.Words() || !dom_x.Words() ) continue;
+		typename T::ConstraintRange const constr = cg.GetEdgeConstraints(e);
+		typename T::ConstraintRange::const_iterator b_c = constr.begin();
+		typename T::ConstraintRange::const_iterator e_c = constr.end();
+		for ( ; b_c!=e_c && (*b_c)->GetVars().size() == 2; ++b_c ) {}
+		if ( b_c != e_c ) continue;
+
+		unsigned const num_words = dom_x.NumWords();
+		unsigned const offset = supports.size();
+		supports.resize( offset + dom_y.Universe() * num_words, 0 );
+		row.resize( num_words );
+		typename Domain::const_iterator b_y = dom_y.begin();
+		typename Domain::const_iterator e_y = dom_y.end();
+		for ( ; b_y!=e_y; ++b_y ) {
+			Word* support = &supports[ offset + dom_y.IndexOf(*b_y) * num_words ];
+			std::fill( support, support + num_words, ~Word(0) );
+			for ( b_c = constr.begin(); b_c!=e_c; ++b_c ) {
+				std::fill( row.begin(), row.end(), 0 );
+				(*b_c)->Supports( (*b_c)->GetVars()[0] == y ? 0 : 1, *b_y, row.data() );
+				for ( unsigned k=0; k<num_words; ++k ) support[k] &= row[k];
+			}
+		}
+		support_offsets[e] = offset;
+	}
+}
+////////////////////////////////////////////////////////////
+//true if all constraints are satisfiable for the current assignment
+template <typename T> 
+INLINE
+bool CSP<T>::AllSatisfiable(const typename T::ConstraintRange& constr) {
+	typename T::ConstraintRange::const_iterator b_c = constr.begin();
+	typename T::ConstraintRange::const_iterator e_c = constr.end();
+	for ( ; b_c!=e_c; ++b_c ) {
+		if ( ! (*b_c)->Satisfiable() ) return false;
+	}
+	return true;
+}
+////////////////////////////////////////////////////////////
+//choose next variable for assignment according to "ordering"
+template <typename T> 
+INLINE
+typename CSP<T>::Variable* CSP<T>::SelectVariable() {
+	switch ( ordering ) {
+		case MRV_DEGREE: return MinRemValMaxDegree();
+		case DOM_DEG:    return MinDomOverDegree(false);
+		case DOM_WDEG:   return MinDomOverDegree(true);
+		case MAX_DEGREE: return MaxDegreeHeuristic();
+		default:         return MinRemVal();
+	}
 }
 ////////////////////////////////////////////////////////////
 //choose next variable for assignment
 //choose the one with minimum remaining values
+//(lowest ID among ties)
 template <typename T> 
 INLINE
 typename CSP<T>::Variable* CSP<T>::MinRemVal() {
-	const typename std::vector<Variable*> vars = cg.GetAllVariables();
+	return buckets.Min();
+}
+////////////////////////////////////////////////////////////
+//choose next variable for assignment
+//minimum remaining values, ties broken by max degree
+template <typename T> 
+INLINE
+typename CSP<T>::Variable* CSP<T>::MinRemValMaxDegree() {
+	candidates.clear();
+	buckets.GetMin(candidates);
+	Variable* best = candidates.front();
+	if ( candidates.size() == 1 ) return best;
+	unsigned best_degree = Degree(best,false);
+	typename std::vector<Variable*>::const_iterator b_c = candidates.begin()+1;
+	typename std::vector<Variable*>::const_iterator e_c = candidates.end();
+	for ( ; b_c!=e_c; ++b_c ) {
+		unsigned degree = Degree(*b_c,false);
+		if ( degree > best_degree ) { best = *b_c; best_degree = degree; }
+	}
+	return best;
+}
+////////////////////////////////////////////////////////////
+//choose next variable for assignment
+//minimum ratio of domain size and (weighted) degree, 
+//variables with degree 0 go last
+template <typename T> 
+INLINE
+typename CSP<T>::Variable* CSP<T>::MinDomOverDegree(bool weighted) {
+	const std::vector<Variable*>& vars = cg.GetAllVariables();
 	typename std::vector<Variable*>::const_iterator b_vars = vars.begin();
 	typename std::vector<Variable*>::const_iterator e_vars = vars.end();
-	typename std::vector<Variable*>::const_iterator mrv = e_vars;
-	for (; b_vars != e_vars; ++b_vars) {
-		if ((*b_vars)->IsAssigned())
-			continue;
-
-		if (mrv == e_vars)
-      mrv = b_vars;
-
-    if ((*b_vars)->SizeDomain() < (*mrv)->SizeDomain())
-      mrv = b_vars;
+	Variable* best = 0;
+	uint64_t best_size = 0, best_degree = 0;
+	for ( ; b_vars!=e_vars; ++b_vars ) {
+		if ( (*b_vars)->IsAssigned() ) continue;
+		uint64_t size = (*b_vars)->SizeDomain();
+		uint64_t degree = Degree(*b_vars,weighted);
+		//size/degree < best_size/best_degree
+		bool better = 
+			!best ||
+			( degree && !best_degree ) ||
+			( degree && size*best_degree < best_size*degree ) ||
+			( !degree && !best_degree && size < best_size );
+		if ( better ) { best = *b_vars; best_size = size; best_degree = degree; }
+	}
+	return best;
+}
+////////////////////////////////////////////////////////////
+//number (total weight) of constraints on the variable which
+//involve some other unassigned variable
+template <typename T> 
+INLINE
+unsigned CSP<T>::Degree(Variable* x, bool weighted) const {
+	unsigned result = 0;
+	typename T::ConstraintRange const constr = cg.GetConstraints(x);
+	typename T::ConstraintRange::const_iterator b_c = constr.begin();
+	typename T::ConstraintRange::const_iterator e_c = constr.end();
+	for ( ; b_c!=e_c; ++b_c ) {
+		const std::vector<Variable*>& vars = (*b_c)->GetVars();
+		typename std::vector<Variable*>::const_iterator b_v = vars.begin();
+		typename std::vector<Variable*>::const_iterator e_v = vars.end();
+		for ( ; b_v!=e_v; ++b_v ) {
+			if ( *b_v != x && !(*b_v)->IsAssigned() ) {
+				result += weighted ? cg.GetWeight( b_c.ID() ) : 1;
+				break;
+			}
+		}
+	}
+	return result;
+}
+////////////////////////////////////////////////////////////
+//re-file variables whose domains changed since the checkpoint
+template <typename T> 
+INLINE
+void CSP<T>::UpdateBuckets(unsigned checkpoint) {
+	unsigned const end = trail.Checkpoint();
+	for ( unsigned i=checkpoint; i<end; ++i ) {
+		buckets.Update( trail.GetVariable(i) );
+	}
+}
+////////////////////////////////////////////////////////////
+//undo the trail to the checkpoint, re-file restored variables
+template <typename T> 
+INLINE
+void CSP<T>::Backtrack(unsigned checkpoint, unsigned entailed) {
+	cg.RestoreEntailed(entailed);
+	touched.clear();
+	unsigned const end = trail.Checkpoint();
+	for ( unsigned i=checkpoint; i<end; ++i ) {
+		touched.push_back( trail.GetVariable(i) );
+	}
+	trail.Undo(checkpoint);
+	typename std::vector<Variable*>::const_iterator b_t = touched.begin();
+	typename std::vector<Variable*>::const_iterator e_t = touched.end();
+	for ( ; b_t!=e_t; ++b_t ) {
+		buckets.Update( *b_t );
 	}
-
-	return *mrv;
 }
 ////////////////////////////////////////////////////////////
 //choose next variable for assignment
-//choose the one with max degree
+//choose the one with max degree (lowest ID among ties)
 template <typename T> 
 typename CSP<T>::Variable* CSP<T>::MaxDegreeHeuristic() {
-
-	// todo: place holder
-	return {};
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-}
-
-template<typename T>
-inline std::set<typename CSP<T>::Variable::Value>* CSP<T>::CpDomFromVar(
-	CSP<T>::Variable* var
-	) {
-
-	std::set<typename Variable::Value> const& orig = var->GetDomain();
-	typename std::set<typename Variable::Value>::const_iterator b_dom
-		= orig.begin();
-	typename std::set<typename Variable::Value>::const_iterator e_dom
-		= orig.end();
-	std::set<typename CSP<T>::Variable::Value>* const cp
-    = new std::set<typename CSP<T>::Variable::Value>;
-	for (; b_dom != e_dom; ++b_dom) 
-		cp->insert(*b_dom);
-
-	return cp;
+	const std::vector<Variable*>& vars = cg.GetAllVariables();
+	typename std::vector<Variable*>::const_iterator b_vars = vars.begin();
+	typename std::vector<Variable*>::const_iterator e_vars = vars.end();
+	Variable* best = 0;
+	unsigned best_degree = 0;
+	for ( ; b_vars!=e_vars; ++b_vars ) {
+		if ( (*b_vars)->IsAssigned() ) continue;
+		unsigned degree = Degree(*b_vars,false);
+		if ( !best || degree > best_degree ) { best = *b_vars; best_degree = degree; }
+	}
+	return best;
 }
 
 #undef INLINE
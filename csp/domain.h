@@ -0,0 +1,475 @@
+/******************************************************************************/
+/*!
+\file   domain.h
+\brief
+  Set of values available to a Variable.
+  Three interchangeable representations are supported:
+  1) std::set of values - any values, ordered iteration
+  2) dense bitset over [base, base + 64*number of words) - intended for
+     contiguous integer ranges (0..N-1 for queens, 1..N^2 for magic square),
+     size/min/max use popcount/ctz/clz and copying is a word-wise copy
+  3) sparse set - intended for large domains of scattered values.
+     Values are kept in a dense array whose first "count" entries are
+     in the domain, removal swaps the value past that boundary and
+     restoring a value just moves the boundary back. A small hash table
+     maps a value to its slot, so nothing is allocated after creation.
+     Iteration order is arbitrary.
+  The representation is chosen per domain when it is created (AUTO
+  picks a bitset or the std::set, a sparse set is never implicit).
+*/
+/******************************************************************************/
+#ifndef DOMAIN_H
+#define DOMAIN_H
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <stdint.h>
+#if defined(_MSC_VER)
+# include <intrin.h>
+#endif
+#if defined(__AVX2__) || defined(__SSE4_1__)
+# include <immintrin.h>
+#endif
+
+class IntDomain {
+	public:
+		typedef int Value;
+		//! one word of the bitset representation (64 bits, stdint.h
+		//! keeps long long out of -ansi -pedantic builds)
+		typedef uint64_t Word;
+
+		//! storage used for the values
+		enum Representation {
+			AUTO,   //!< bitset if the values are dense enough, std::set otherwise
+			SET,    //!< std::set<Value>
+			BITSET, //!< bitset over a contiguous range of values
+			SPARSE  //!< sparse set of arbitrary values
+		};
+
+		class const_iterator;
+
+		IntDomain();
+		IntDomain( const std::vector<Value> & values, Representation rep = AUTO );
+
+		Representation GetRepresentation() const;
+		unsigned Size() const;
+		bool  Empty() const;
+		bool  Contains(Value val) const;
+		bool  Remove(Value val);
+		void  Restore(Value val);
+		void  Assign(const std::set<Value>& vals);
+		Value Min() const;
+		Value Max() const;
+		const_iterator begin() const;
+		const_iterator end() const;
+		const_iterator lower_bound(Value val) const;
+		unsigned Universe() const;
+		int   IndexOf(Value val) const;
+		//! bitset words (bit IndexOf(val) is val), NULL unless BITSET
+		const Word* Words() const { return rep == BITSET ? words.data() : 0; }
+		unsigned NumWords() const { return rep == BITSET ? words.size() : 0; }
+
+		//! bit tricks on words, precondition for Lowest/HighestBit - w != 0
+		static const unsigned BITS = 64;
+		static unsigned CountBits(Word w);
+		static unsigned LowestBit(Word w);
+		static unsigned HighestBit(Word w);
+		//! a & b != 0 for bitsets of n words (AVX2/SSE4.1 if enabled)
+		static bool Intersects(const Word* a, const Word* b, unsigned n);
+
+	private:
+		void  BuildBitset(const std::vector<Value> & values);
+		//position of the next value in the bitset after bit "pos", -1 if none
+		int   NextBit(int pos) const;
+		void  BuildSparse(const std::vector<Value> & values);
+		//slot of the value in the sparse set, -1 if it was never in the domain
+		int   FindSlot(Value val) const;
+		unsigned Hash(Value val) const;
+		void  SwapPositions(unsigned i, unsigned j);
+
+		//! which of the members below hold the values
+		Representation rep;
+		//! values when rep == SET
+		std::set<Value> values;
+		//! value corresponding to bit 0 of words[0] when rep == BITSET
+		Value base;
+		//! bitset when rep == BITSET
+		std::vector<Word> words;
+		//! all values ever in the domain when rep == SPARSE, a value is 
+		//! identified by its slot (index) in this array
+		std::vector<Value> initial;
+		//! slots ordered so that the first count are in the domain (SPARSE)
+		std::vector<unsigned> dense;
+		//! position of each slot in dense (SPARSE)
+		std::vector<unsigned> where;
+		//! open addressing table: slot + 1 of a value, 0 is empty (SPARSE)
+		std::vector<unsigned> table;
+		//! number of values currently in the domain
+		unsigned count;
+};
+
+/******************************************************************************/
+/*!
+  \class IntDomain::const_iterator
+  \brief
+  Forward iterator over the values of the domain (in increasing order
+  for SET and BITSET). Removing values from the domain invalidates iterators.
+*/
+/******************************************************************************/
+class IntDomain::const_iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef IntDomain::Value value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const IntDomain::Value* pointer;
+		typedef const IntDomain::Value& reference;
+
+		const_iterator() : dom(0), it(), pos(-1), val() {}
+		IntDomain::Value operator*() const { 
+			if ( dom->rep == SET ) return *it;
+			if ( dom->rep == SPARSE ) return dom->initial[ dom->dense[pos] ];
+			return val;
+		}
+		const_iterator& operator++() {
+			if ( dom->rep == SET ) { ++it; }
+			else if ( dom->rep == SPARSE ) { 
+				if ( static_cast<unsigned>(++pos) >= dom->count ) pos = -1;
+			}
+			else { pos = dom->NextBit(pos); val = dom->base + pos; }
+			return *this;
+		}
+		const_iterator operator++(int) { const_iterator tmp(*this); ++*this; return tmp; }
+		bool operator==(const const_iterator& rhs) const {
+			return dom->rep == SET ? it == rhs.it : pos == rhs.pos;
+		}
+		bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+	private:
+		friend class IntDomain;
+		const IntDomain* dom;
+		std::set<IntDomain::Value>::const_iterator it; //SET
+		int pos;                                       //BITSET/SPARSE, -1 is end
+		IntDomain::Value val;                          //BITSET, value at pos
+};
+
+////////////////////////////////////////////////////////////
+//bit tricks, MSC does not have 64-bit scans on Win32
+//so work with 32-bit halves there
+////////////////////////////////////////////////////////////
+#if defined(_MSC_VER)
+inline unsigned IntDomain::CountBits(Word w) {
+	return __popcnt( static_cast<unsigned>(w) ) + __popcnt( static_cast<unsigned>(w>>32) );
+}
+inline unsigned IntDomain::LowestBit(Word w) {
+	unsigned long i;
+	if ( _BitScanForward(&i, static_cast<unsigned long>(w)) ) return i;
+	_BitScanForward(&i, static_cast<unsigned long>(w>>32));
+	return i+32;
+}
+inline unsigned IntDomain::HighestBit(Word w) {
+	unsigned long i;
+	if ( _BitScanReverse(&i, static_cast<unsigned long>(w>>32)) ) return i+32;
+	_BitScanReverse(&i, static_cast<unsigned long>(w));
+	return i;
+}
+#else
+inline unsigned IntDomain::CountBits(Word w)  { return __builtin_popcountll(w); }
+inline unsigned IntDomain::LowestBit(Word w)  { return __builtin_ctzll(w); }
+inline unsigned IntDomain::HighestBit(Word w) { return BITS - 1 - __builtin_clzll(w); }
+#endif
+
+////////////////////////////////////////////////////////////
+//empty domain
+inline IntDomain::IntDomain() : 
+	rep(SET), values(), base(), words(), initial(), dense(), where(), table(), count(0) 
+{}
+
+////////////////////////////////////////////////////////////
+//domain containing given values, AUTO chooses bitset when the range
+//of values is at most 8 times larger than the number of values
+//and std::set otherwise (ordered, so the search order does not
+//depend on the representation - SPARSE only on request)
+inline IntDomain::IntDomain( const std::vector<Value> & vals, Representation r ) :
+	rep(r), values(), base(), words(), initial(), dense(), where(), table(), count(0)
+{
+	if ( rep == AUTO ) {
+		rep = SET;
+		if ( !vals.empty() ) {
+			//max-min in unsigned arithmetic, exact for any two ints
+			unsigned long const span =
+				static_cast<unsigned long>( *std::max_element(vals.begin(),vals.end()) ) -
+				static_cast<unsigned long>( *std::min_element(vals.begin(),vals.end()) );
+			if ( span < BITS || span < 8 * static_cast<unsigned long>(vals.size()) ) rep = BITSET;
+		}
+	}
+	if ( rep == BITSET ) { BuildBitset( vals ); }
+	else if ( rep == SPARSE ) { BuildSparse( vals ); }
+	else {
+		values.insert( vals.begin(), vals.end() );
+		count = values.size();
+	}
+}
+
+////////////////////////////////////////////////////////////
+//lay out bitset so that it covers all given values
+inline void IntDomain::BuildBitset( const std::vector<Value> & vals ) {
+	words.clear();
+	count = 0;
+	if ( vals.empty() ) { base = Value(); return; }
+	base = *std::min_element(vals.begin(),vals.end());
+	Value max = *std::max_element(vals.begin(),vals.end());
+	words.resize( static_cast<unsigned>(max-base)/BITS + 1, 0 );
+	std::vector<Value>::const_iterator b_vals = vals.begin();
+	std::vector<Value>::const_iterator e_vals = vals.end();
+	for ( ;b_vals!=e_vals;++b_vals) {
+		unsigned bit = static_cast<unsigned>(*b_vals - base);
+		words[bit/BITS] |= Word(1) << (bit%BITS);
+	}
+	std::vector<Word>::const_iterator b_words = words.begin();
+	std::vector<Word>::const_iterator e_words = words.end();
+	for ( ;b_words!=e_words;++b_words) { count += CountBits(*b_words); }
+}
+
+////////////////////////////////////////////////////////////
+//fill the sparse set and the hash table, duplicates are skipped
+inline void IntDomain::BuildSparse( const std::vector<Value> & vals ) {
+	initial.clear();
+	unsigned size = 4;
+	while ( size < 2*vals.size() ) size *= 2;
+	table.assign( size, 0 );
+	std::vector<Value>::const_iterator b_vals = vals.begin();
+	std::vector<Value>::const_iterator e_vals = vals.end();
+	for ( ;b_vals!=e_vals;++b_vals) {
+		unsigned h = Hash(*b_vals);
+		while ( table[h] != 0 && initial[table[h]-1] != *b_vals ) {
+			h = (h+1) & (size-1);
+		}
+		if ( table[h] == 0 ) {
+			initial.push_back(*b_vals);
+			table[h] = initial.size();
+		}
+	}
+	dense.resize( initial.size() );
+	where.resize( initial.size() );
+	for ( unsigned i=0; i<initial.size(); ++i ) { dense[i] = where[i] = i; }
+	count = initial.size();
+}
+
+////////////////////////////////////////////////////////////
+//multiplicative hashing into the table of SPARSE
+inline unsigned IntDomain::Hash(Value val) const {
+	return ( static_cast<unsigned>(val) * 2654435761u ) & (table.size()-1);
+}
+
+////////////////////////////////////////////////////////////
+//initial position of the value in SPARSE, -1 if unknown value
+inline int IntDomain::FindSlot(Value val) const {
+	unsigned h = Hash(val);
+	while ( table[h] != 0 ) {
+		if ( initial[table[h]-1] == val ) return table[h]-1;
+		h = (h+1) & (table.size()-1);
+	}
+	return -1;
+}
+
+////////////////////////////////////////////////////////////
+//exchange 2 entries of dense, keeping "where" in sync
+inline void IntDomain::SwapPositions(unsigned i, unsigned j) {
+	unsigned si = dense[i];
+	unsigned sj = dense[j];
+	dense[i] = sj;
+	dense[j] = si;
+	where[sj] = i;
+	where[si] = j;
+}
+
+////////////////////////////////////////////////////////////
+inline IntDomain::Representation IntDomain::GetRepresentation() const { return rep; }
+
+////////////////////////////////////////////////////////////
+inline unsigned IntDomain::Size() const { return count; }
+
+////////////////////////////////////////////////////////////
+inline bool IntDomain::Empty() const { return count == 0; }
+
+////////////////////////////////////////////////////////////
+inline bool IntDomain::Contains(Value val) const {
+	if ( rep == SET ) return values.find(val) != values.end();
+	if ( rep == SPARSE ) {
+		int slot = FindSlot(val);
+		return slot >= 0 && where[slot] < count;
+	}
+	if ( val < base ) return false;
+	unsigned bit = static_cast<unsigned>(val - base);
+	if ( bit/BITS >= words.size() ) return false;
+	return ( words[bit/BITS] >> (bit%BITS) ) & 1;
+}
+
+////////////////////////////////////////////////////////////
+//returns false if the value is not in the domain
+inline bool IntDomain::Remove(Value val) {
+	if ( rep == SET ) {
+		if ( values.erase(val) == 0 ) return false;
+		--count;
+		return true;
+	}
+	if ( rep == SPARSE ) {
+		//swap past the boundary
+		int slot = FindSlot(val);
+		if ( slot < 0 || where[slot] >= count ) return false;
+		SwapPositions( where[slot], --count );
+		return true;
+	}
+	if ( !Contains(val) ) return false;
+	unsigned bit = static_cast<unsigned>(val - base);
+	words[bit/BITS] &= ~( Word(1) << (bit%BITS) );
+	--count;
+	return true;
+}
+
+////////////////////////////////////////////////////////////
+//put back a value removed by Remove (used when backtracking)
+//precondition - value was removed from this domain
+inline void IntDomain::Restore(Value val) {
+	if ( rep == SET ) { values.insert(val); }
+	else if ( rep == SPARSE ) {
+		//values restored in reverse order of removal are right 
+		//past the boundary, otherwise swap the value there first
+		if ( initial[ dense[count] ] != val ) {
+			SwapPositions( where[ FindSlot(val) ], count );
+		}
+	}
+	else {
+		unsigned bit = static_cast<unsigned>(val - base);
+		words[bit/BITS] |= Word(1) << (bit%BITS);
+	}
+	++count;
+}
+
+////////////////////////////////////////////////////////////
+//replace values, bitset is re-laid out if it cannot hold the new values
+inline void IntDomain::Assign(const std::set<Value>& vals) {
+	if ( rep == SET ) {
+		values = vals;
+		count = values.size();
+		return;
+	}
+	if ( rep == SPARSE ) { BuildSparse( std::vector<Value>(vals.begin(),vals.end()) ); }
+	else                 { BuildBitset( std::vector<Value>(vals.begin(),vals.end()) ); }
+}
+
+////////////////////////////////////////////////////////////
+//precondition - domain is not empty, linear for SPARSE
+inline IntDomain::Value IntDomain::Min() const {
+	if ( rep == SET ) return *values.begin();
+	if ( rep == SPARSE ) {
+		Value result = initial[ dense[0] ];
+		for ( unsigned i=1; i<count; ++i ) { result = std::min( result, initial[ dense[i] ] ); }
+		return result;
+	}
+	unsigned w = 0;
+	while ( words[w] == 0 ) ++w;
+	return base + static_cast<Value>( w*BITS + LowestBit(words[w]) );
+}
+
+////////////////////////////////////////////////////////////
+//precondition - domain is not empty, linear for SPARSE
+inline IntDomain::Value IntDomain::Max() const {
+	if ( rep == SET ) return *values.rbegin();
+	if ( rep == SPARSE ) {
+		Value result = initial[ dense[0] ];
+		for ( unsigned i=1; i<count; ++i ) { result = std::max( result, initial[ dense[i] ] ); }
+		return result;
+	}
+	unsigned w = words.size() - 1;
+	while ( words[w] == 0 ) --w;
+	return base + static_cast<Value>( w*BITS + HighestBit(words[w]) );
+}
+
+////////////////////////////////////////////////////////////
+inline int IntDomain::NextBit(int pos) const {
+	unsigned bit = static_cast<unsigned>(pos+1);
+	unsigned w = bit/BITS;
+	if ( w >= words.size() ) return -1;
+	Word rest = words[w] & ( ~Word(0) << (bit%BITS) );
+	while ( rest == 0 ) {
+		if ( ++w == words.size() ) return -1;
+		rest = words[w];
+	}
+	return static_cast<int>( w*BITS + LowestBit(rest) );
+}
+
+////////////////////////////////////////////////////////////
+inline IntDomain::const_iterator IntDomain::begin() const {
+	const_iterator result;
+	result.dom = this;
+	if ( rep == SET ) { result.it = values.begin(); }
+	else if ( rep == SPARSE ) { result.pos = count > 0 ? 0 : -1; }
+	else { result.pos = NextBit(-1); result.val = base + result.pos; }
+	return result;
+}
+
+////////////////////////////////////////////////////////////
+inline IntDomain::const_iterator IntDomain::end() const {
+	const_iterator result;
+	result.dom = this;
+	result.it = values.end();
+	return result;
+}
+
+////////////////////////////////////////////////////////////
+//first value not less than val, SPARSE is not ordered - 
+//returns begin()
+inline IntDomain::const_iterator IntDomain::lower_bound(Value val) const {
+	if ( rep == SPARSE ) return begin();
+	const_iterator result;
+	result.dom = this;
+	if ( rep == SET ) { result.it = values.lower_bound(val); }
+	else if ( val <= base ) { return begin(); }
+	else { result.pos = NextBit( static_cast<int>(val - base) - 1 ); result.val = base + result.pos; }
+	return result;
+}
+
+////////////////////////////////////////////////////////////
+//number of indices returned by IndexOf (0 for SET)
+inline unsigned IntDomain::Universe() const {
+	if ( rep == SET ) return 0;
+	if ( rep == SPARSE ) return initial.size();
+	return words.size() * BITS;
+}
+
+////////////////////////////////////////////////////////////
+//index of the value among all values the domain can hold
+//(0..Universe()-1), fixed as long as the domain is not re-assigned,
+//-1 if the value is unknown or the domain is a SET
+inline int IntDomain::IndexOf(Value val) const {
+	if ( rep == SET ) return -1;
+	if ( rep == SPARSE ) return FindSlot(val);
+	if ( val < base || static_cast<unsigned>(val - base) >= Universe() ) return -1;
+	return static_cast<int>(val - base);
+}
+
+////////////////////////////////////////////////////////////
+inline bool IntDomain::Intersects(const Word* a, const Word* b, unsigned n) {
+	unsigned i = 0;
+#if defined(__AVX2__)
+	for ( ; i+4<=n; i+=4 ) {
+		__m256i va = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a+i ) );
+		__m256i vb = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( b+i ) );
+		if ( !_mm256_testz_si256( va, vb ) ) return true;
+	}
+#elif defined(__SSE4_1__)
+	for ( ; i+2<=n; i+=2 ) {
+		__m128i va = _mm_loadu_si128( reinterpret_cast<const __m128i*>( a+i ) );
+		__m128i vb = _mm_loadu_si128( reinterpret_cast<const __m128i*>( b+i ) );
+		if ( !_mm_testz_si128( va, vb ) ) return true;
+	}
+#endif
+	for ( ; i<n; ++i ) {
+		if ( a[i] & b[i] ) return true;
+	}
+	return false;
+}
+
+#endif
@@ -5,9 +5,13 @@
 #include "contraints.h"
 #include "variable.h"
 #include "csp.h"
+#if defined(WORKERS) || defined(PORTFOLIO)
+#include "parallel.h"
+#endif
 #include <cmath>
 #include <cstdlib>
 #include <ctime>
+#include <algorithm>
 
 
 ////////////////////////////////////////////////////////////
@@ -29,6 +33,17 @@ std::vector<int> getVector(int val, ...) {
 	return result;
 }
 
+#ifdef PORTFOLIO
+//strategies raced by the PORTFOLIO drivers
+void AddStrategies(Portfolio<ConstraintGraph<Constraint<Variable> > >& portfolio) {
+	typedef CSP<ConstraintGraph<Constraint<Variable> > > Solver;
+	portfolio.AddStrategy( "FC MRV", &Solver::SolveFC, Solver::MRV );
+	portfolio.AddStrategy( "FC DOM_WDEG", &Solver::SolveFC, Solver::DOM_WDEG );
+	portfolio.AddStrategy( "ARC MRV", &Solver::SolveARC, Solver::MRV );
+	portfolio.AddStrategy( "PROP DOM_WDEG", &Solver::SolvePROP, Solver::DOM_WDEG );
+}
+#endif
+
 
 #ifdef EXAMPLE
 int main () {
@@ -99,9 +114,9 @@ int main () {
 		cg.Print();
 		cg.PreProcess();
 
-		std::set<Variable*> neighbors = cg.GetNeighbors(&w2);
-		std::set<Variable*>::const_iterator b_neighbor = neighbors.begin();
-		std::set<Variable*>::const_iterator e_neighbor = neighbors.end();
+		ConstraintGraph<Constraint<Variable> >::VariableRange neighbors = cg.GetNeighbors(&w2);
+		ConstraintGraph<Constraint<Variable> >::VariableRange::const_iterator b_neighbor = neighbors.begin();
+		ConstraintGraph<Constraint<Variable> >::VariableRange::const_iterator e_neighbor = neighbors.end();
 		std::cout << "Neighbors of " << w2 << " are \n";
 		for ( ; b_neighbor!=e_neighbor; ++b_neighbor ) {
 			std::cout << "--- " << **b_neighbor;
@@ -153,6 +168,9 @@ int main () {
 #ifdef ARC
 			csp.SolveARC(0) 
 #endif
+#ifdef PROP
+			csp.SolvePROP(0) 
+#endif
 #ifdef FC
 			csp.SolveFC(0) 
 #endif
@@ -172,6 +190,69 @@ int main () {
 }
 #endif
 
+#ifdef CLIQUES
+int main () {
+	//overlapping cliques of AllDiff2 - x0,x1,x2 and x0,x1,x3 share the
+	//edge x0 x1, both have to be fused into their own AllDiff:
+	//x3 takes x2's value, 6 solutions
+	std::vector<int> range = getVector(0,1,2,NULL);
+	bool correct = true;
+	for ( int fuse=0; fuse<2; ++fuse ) {
+		std::vector<Variable*> x;
+		for ( int i=0; i<4; ++i ) {
+			char name[8];
+			std::sprintf( name, "x%d", i );
+			x.push_back( new Variable( name, range ) );
+		}
+		ConstraintGraph<Constraint<Variable> > cg;
+		for ( int i=0; i<4; ++i ) cg.InsertVariable( *x[i] );
+		cg.InsertConstraint( AllDiff2<Variable>( x[0], x[1] ) );
+		cg.InsertConstraint( AllDiff2<Variable>( x[0], x[2] ) );
+		cg.InsertConstraint( AllDiff2<Variable>( x[1], x[2] ) );
+		cg.InsertConstraint( AllDiff2<Variable>( x[0], x[3] ) );
+		cg.InsertConstraint( AllDiff2<Variable>( x[1], x[3] ) );
+		cg.SetCliqueFusion( fuse == 1 );
+		cg.PreProcess();
+
+		CSP<ConstraintGraph<Constraint<Variable> > > csp( cg );
+		csp.SolveFC_count(0);
+		std::cout << ( fuse ? "fused   " : "pairwise" ) << " constraints " << cg.NumConstraints() 
+			<< " solutions " << csp.GetSolutionCounter() << std::endl;
+		correct = correct && csp.GetSolutionCounter() == 6;
+		for ( int i=0; i<4; ++i ) delete x[i];
+	}
+	if ( correct ) std::cout << "Solution counter is correct\n";
+	else std::cout << "FAILED - wrong number of solutions\n";
+}
+#endif
+
+#ifdef SINGLETONS
+int main () {
+	//odd cycle x!=y, y!=z, z!=x over {0,1}: assigning x leaves y and z
+	//with a single value each, the singleton y has to wake up y!=z
+	//which wipes out z - both values of x fail at the first level
+	std::vector<int> range = getVector(0,1,NULL);
+	Variable* x = new Variable( "x", range );
+	Variable* y = new Variable( "y", range );
+	Variable* z = new Variable( "z", range );
+	ConstraintGraph<Constraint<Variable> > cg;
+	cg.InsertVariable( *x );
+	cg.InsertVariable( *y );
+	cg.InsertVariable( *z );
+	cg.InsertConstraint( AllDiff2<Variable>( x, y ) );
+	cg.InsertConstraint( AllDiff2<Variable>( y, z ) );
+	cg.InsertConstraint( AllDiff2<Variable>( z, x ) );
+	cg.PreProcess();
+
+	CSP<ConstraintGraph<Constraint<Variable> > > csp( cg );
+	bool solved = csp.SolvePROP(0);
+	std::cout << "Recursive call counter = " << csp.GetRecursiveCallCounter() << std::endl;
+	if ( !solved && csp.GetRecursiveCallCounter() == 1 ) std::cout << "Propagation is correct\n";
+	else std::cout << "FAILED - singleton was not propagated\n";
+	delete x; delete y; delete z;
+}
+#endif
+
 
 
 #ifdef MSBC
@@ -241,14 +322,37 @@ int main () try { //magic square SIZExSIZE
 	////////////////////////////////////////////////////////////
 	////////////////////////////////////////////////////////////
 	//cg.Print();
+#ifdef FUSED //cliques of AllDiff2 replaced by AllDiff
+	cg.SetCliqueFusion( true );
+#endif
+#ifdef BATCHED //pairwise model, binary constraints checked without virtual calls
+	cg.SetCliqueFusion( false );
+	cg.SetBatching( true );
+#endif
 	cg.PreProcess();
 
+#ifdef WORKERS //work-stealing search on WORKERS threads (DFS, FC)
+	ParallelSearch<ConstraintGraph<Constraint<Variable> > > csp( cg, WORKERS );
+#elif defined(PORTFOLIO) //strategies racing on threads, see AddStrategies
+	Portfolio<ConstraintGraph<Constraint<Variable> > > csp( cg );
+	AddStrategies( csp );
+#else
 	CSP<ConstraintGraph<Constraint<Variable> > > csp( cg );
+#endif
+#ifdef ORDERING //MRV_DEGREE, DOM_DEG, DOM_WDEG, MAX_DEGREE
+	csp.SetVariableOrdering( CSP<ConstraintGraph<Constraint<Variable> > >::ORDERING );
+#endif
+#ifdef ENTAILMENT //constraints that cannot fail are skipped until backtracking
+	csp.SetEntailment( true );
+#endif
 	clock_t start = std::clock();
 	if ( 
 #ifdef ARC
 			csp.SolveARC(0) 
 #endif
+#ifdef PROP
+			csp.SolvePROP(0) 
+#endif
 #ifdef FC
 			csp.SolveFC(0) 
 #endif
@@ -257,6 +361,12 @@ int main () try { //magic square SIZExSIZE
 #endif
 #ifdef DFScount
 			csp.SolveFC_count(0)
+#endif
+#ifdef ITERATIVE //no recursion, BACKTRACKING, FORWARD_CHECKING, ARC_CONSISTENCY, PROPAGATION
+			csp.SolveIterative( CSP<ConstraintGraph<Constraint<Variable> > >::ITERATIVE )
+#endif
+#ifdef PORTFOLIO
+			csp.Solve()
 #endif
 	   ) {
 		//cg.Print();
@@ -264,10 +374,35 @@ int main () try { //magic square SIZExSIZE
 #ifdef DFScount
 			std::cout << "Solution counter = " 
 				<< csp.GetSolutionCounter() << std::endl;
+		std::cout << "Time " << static_cast<float>(finish-start)/CLOCKS_PER_SEC << std::endl;
+#ifdef WORKERS
+		for (unsigned w=0;w<csp.NumWorkers();++w) {
+			std::cout << "Worker " << w << " cubes " << csp.GetCubeCounter(w) 
+				<< " solutions " << csp.GetSolutionCounter(w) << std::endl;
+		}
+		std::cout << "Wall time " << csp.GetWallTime() << std::endl;
+		std::cout << "Speedup not measured - compare with the Wall time of a -DWORKERS=1 build" << std::endl;
+#endif
 #else
 		std::cout << "Time " << static_cast<float>(finish-start)/CLOCKS_PER_SEC << std::endl;
 		std::cout << "RecursiveCallCounter = " << csp.GetRecursiveCallCounter() << std::endl;
 		std::cout << "IterationCounter     = " << csp.GetIterationCounter() << std::endl;
+#ifdef WORKERS
+		for (unsigned w=0;w<csp.NumWorkers();++w) {
+			std::cout << "Worker " << w << " RecursiveCallCounter = " << csp.GetRecursiveCallCounter(w) 
+				<< " steals " << csp.GetStealCounter(w) << std::endl;
+		}
+		std::cout << "Wall time " << csp.GetWallTime() << std::endl;
+		std::cout << "Speedup not measured - compare with the Wall time of a -DWORKERS=1 build" << std::endl;
+#endif
+#ifdef PORTFOLIO
+		for (unsigned s=0;s<csp.NumStrategies();++s) {
+			std::cout << "Strategy " << csp.GetName(s) << " RecursiveCallCounter = " << csp.GetRecursiveCallCounter(s) 
+				<< " wins " << csp.GetWinCounter(s) << std::endl;
+		}
+		std::cout << "Winner " << csp.GetName( csp.GetWinner() ) << std::endl;
+		std::cout << "Wall time " << csp.GetWallTime() << std::endl;
+#endif
 
 		for (unsigned i=0;i<SIZE;++i) {
 			for (unsigned j=0;j<SIZE;++j) {
@@ -288,6 +423,31 @@ int main () try { //magic square SIZExSIZE
 }
 #endif
 
+#if defined(MS) && defined(EXTENSIONAL)
+//allow all tuples of different values from 1..SIZE*SIZE adding up 
+//to sum (the rest of the tuple is filled from position "pos")
+void AddSumTuples(Table<Variable>* table, std::vector<int>& tuple, unsigned pos, int sum) {
+	if ( pos == tuple.size() ) {
+		if ( sum == 0 ) table->AddTuple( tuple );
+		return;
+	}
+	for ( int val=1; val<=SIZE*SIZE && val<=sum; ++val ) {
+		if ( std::find( tuple.begin(), tuple.begin()+pos, val ) != tuple.begin()+pos ) continue;
+		tuple[pos] = val;
+		AddSumTuples( table, tuple, pos+1, sum-val );
+	}
+}
+//the same sum given by a table of allowed tuples, replaces "sum"
+Constraint<Variable>* SumTable(Constraint<Variable>* sum, int magic_constant) {
+	Table<Variable>* table = new Table<Variable>();
+	for (unsigned i=0;i<sum->GetVars().size();++i) { table->AddVariable( sum->GetVars()[i] ); }
+	std::vector<int> tuple( sum->GetVars().size() );
+	AddSumTuples( table, tuple, 0, magic_constant );
+	delete sum;
+	return table;
+}
+#endif
+
 #ifdef MS
 int main () try {//magic square SIZExSIZE
 	const int magic_constant = (SIZE*SIZE*SIZE + SIZE ) /2;
@@ -315,11 +475,17 @@ int main () try {//magic square SIZExSIZE
 		//row
 		constraints[index] = new SumEqual<Variable,magic_constant>();
 		for (unsigned j=0;j<SIZE;++j) { constraints[index]->AddVariable( variables[ i*SIZE +j ] ); }
+#ifdef EXTENSIONAL //sums as tables of allowed tuples
+		constraints[index] = SumTable( constraints[index], magic_constant );
+#endif
 		cg.InsertConstraint( *constraints[index] );
 		++index;
 		//column
 		constraints[index] = new SumEqual<Variable,magic_constant>();
 		for (unsigned j=0;j<SIZE;++j) { constraints[index]->AddVariable( variables[ j*SIZE +i ] ); }
+#ifdef EXTENSIONAL
+		constraints[index] = SumTable( constraints[index], magic_constant );
+#endif
 		cg.InsertConstraint( *constraints[index] );
 		++index;
 	}
@@ -328,6 +494,9 @@ int main () try {//magic square SIZExSIZE
 	for (unsigned i=0;i<SIZE;++i) { 
 		constraints[index]->AddVariable( variables[ (SIZE+1)*i ] ); 
 	}
+#ifdef EXTENSIONAL
+	constraints[index] = SumTable( constraints[index], magic_constant );
+#endif
 	cg.InsertConstraint( *constraints[index] );
 	++index;
 	//secondary diagonal
@@ -335,11 +504,18 @@ int main () try {//magic square SIZExSIZE
 	for (unsigned i=0;i<SIZE;++i) { 
 		constraints[index]->AddVariable( variables[ SIZE-1 + (SIZE-1)*i ] ); 
 	}
+#ifdef EXTENSIONAL
+	constraints[index] = SumTable( constraints[index], magic_constant );
+#endif
 	cg.InsertConstraint( *constraints[index] );
 	++index;
 
 	//all different - single constraint
-	constraints[index] = new AllDiff<Variable>();
+	AllDiff<Variable>* all_diff = new AllDiff<Variable>();
+#ifdef ALLDIFF //BOUNDS, GAC
+	all_diff->SetConsistency( AllDiff<Variable>::ALLDIFF );
+#endif
+	constraints[index] = all_diff;
 	for (int j=0;j<NUM_VARIABLES;++j) { 
 		constraints[index]->AddVariable( variables[ j ] ); 
 	}
@@ -352,12 +528,28 @@ int main () try {//magic square SIZExSIZE
 	//cg.Print();
 	cg.PreProcess();
 
+#ifdef WORKERS //work-stealing search on WORKERS threads (DFS, FC)
+	ParallelSearch<ConstraintGraph<Constraint<Variable> > > csp( cg, WORKERS );
+#elif defined(PORTFOLIO) //strategies racing on threads, see AddStrategies
+	Portfolio<ConstraintGraph<Constraint<Variable> > > csp( cg );
+	AddStrategies( csp );
+#else
 	CSP<ConstraintGraph<Constraint<Variable> > > csp( cg );
+#endif
+#ifdef ORDERING //MRV_DEGREE, DOM_DEG, DOM_WDEG, MAX_DEGREE
+	csp.SetVariableOrdering( CSP<ConstraintGraph<Constraint<Variable> > >::ORDERING );
+#endif
+#ifdef ENTAILMENT //constraints that cannot fail are skipped until backtracking
+	csp.SetEntailment( true );
+#endif
 	clock_t start = std::clock();
 	if ( 
 #ifdef ARC
 			csp.SolveARC(0) 
 #endif
+#ifdef PROP
+			csp.SolvePROP(0) 
+#endif
 #ifdef FC
 			csp.SolveFC(0) 
 #endif
@@ -366,6 +558,12 @@ int main () try {//magic square SIZExSIZE
 #endif
 #ifdef DFScount
 			csp.SolveFC_count(0)
+#endif
+#ifdef ITERATIVE //no recursion, BACKTRACKING, FORWARD_CHECKING, ARC_CONSISTENCY, PROPAGATION
+			csp.SolveIterative( CSP<ConstraintGraph<Constraint<Variable> > >::ITERATIVE )
+#endif
+#ifdef PORTFOLIO
+			csp.Solve()
 #endif
 	   ) {
 		clock_t finish = std::clock();
@@ -373,10 +571,35 @@ int main () try {//magic square SIZExSIZE
 #ifdef DFScount
 		std::cout << "Solution counter = " 
 			<< csp.GetSolutionCounter() << std::endl;
+		std::cout << "Time " << static_cast<float>(finish-start)/CLOCKS_PER_SEC << std::endl;
+#ifdef WORKERS
+		for (unsigned w=0;w<csp.NumWorkers();++w) {
+			std::cout << "Worker " << w << " cubes " << csp.GetCubeCounter(w) 
+				<< " solutions " << csp.GetSolutionCounter(w) << std::endl;
+		}
+		std::cout << "Wall time " << csp.GetWallTime() << std::endl;
+		std::cout << "Speedup not measured - compare with the Wall time of a -DWORKERS=1 build" << std::endl;
+#endif
 #else
 		std::cout << "Time " << static_cast<float>(finish-start)/CLOCKS_PER_SEC << std::endl;
 		std::cout << "RecursiveCallCounter = " << csp.GetRecursiveCallCounter() << std::endl;
 		std::cout << "IterationCounter     = " << csp.GetIterationCounter() << std::endl;
+#ifdef WORKERS
+		for (unsigned w=0;w<csp.NumWorkers();++w) {
+			std::cout << "Worker " << w << " RecursiveCallCounter = " << csp.GetRecursiveCallCounter(w) 
+				<< " steals " << csp.GetStealCounter(w) << std::endl;
+		}
+		std::cout << "Wall time " << csp.GetWallTime() << std::endl;
+		std::cout << "Speedup not measured - compare with the Wall time of a -DWORKERS=1 build" << std::endl;
+#endif
+#ifdef PORTFOLIO
+		for (unsigned s=0;s<csp.NumStrategies();++s) {
+			std::cout << "Strategy " << csp.GetName(s) << " RecursiveCallCounter = " << csp.GetRecursiveCallCounter(s) 
+				<< " wins " << csp.GetWinCounter(s) << std::endl;
+		}
+		std::cout << "Winner " << csp.GetName( csp.GetWinner() ) << std::endl;
+		std::cout << "Wall time " << csp.GetWallTime() << std::endl;
+#endif
 
 		for (unsigned i=0;i<SIZE;++i) {
 			for (unsigned j=0;j<SIZE;++j) {
@@ -403,6 +626,7 @@ int main () {
 	//x_i is in column i
 	//AllDiff(x_1,...,x_n)
 	//|x_i - x_j| != |i-j|
+	//(with GLOBAL one Queens(x_1,...,x_n) instead)
 	try {
 		ConstraintGraph<Constraint<Variable> > cg;
 
@@ -411,7 +635,7 @@ int main () {
 
 		Variable ** array_of_variables = new Variable* [SIZE];
 		for (int i=0;i<SIZE;++i) {
-			char name[5];
+			char name[16];
 			sprintf(name,"x%i",i);
 			array_of_variables[i] = new Variable ( name, range );
 			cg.InsertVariable(*array_of_variables[i]);
@@ -419,7 +643,17 @@ int main () {
 
 
 		unsigned index = 0;
-		Constraint<Variable>* array_of_constraints[SIZE*(SIZE-1)];
+#ifdef GLOBAL //O(SIZE) memory, no neighbors (SIZE^2 of them)
+		const int NUM_CONSTRAINTS = 1;
+		Constraint<Variable>* array_of_constraints[NUM_CONSTRAINTS];
+		array_of_constraints[index] = new Queens<Variable>();
+		for (int i=0;i<SIZE;++i) { array_of_constraints[index]->AddVariable( array_of_variables[i] ); }
+		cg.InsertConstraint( *array_of_constraints[index] );
+		++index;
+		cg.SetNeighbors( false );
+#else
+		const int NUM_CONSTRAINTS = SIZE*(SIZE-1);
+		Constraint<Variable>* array_of_constraints[NUM_CONSTRAINTS];
 		for (unsigned i=0;i<SIZE-1;++i) {
 			for (unsigned j=i+1;j<SIZE;++j) {
 				//|xi-xj| != |j-i|
@@ -434,16 +668,46 @@ int main () {
 				++index;
 			}
 		}
+#endif
 
 		//cg.Print();
+#ifdef TABLES //pairwise model with tabulated binary constraints
+		cg.SetCliqueFusion( false );
+#endif
+#ifdef FUSED //cliques of AllDiff2 replaced by AllDiff
+		cg.SetCliqueFusion( true );
+#endif
+#ifdef BATCHED //pairwise model, binary constraints checked without virtual calls
+		cg.SetCliqueFusion( false );
+		cg.SetBatching( true );
+#endif
 		cg.PreProcess();
 
-		CSP<ConstraintGraph<Constraint<Variable> > > csp( cg );
+	#ifdef WORKERS //work-stealing search on WORKERS threads (DFS, FC)
+	ParallelSearch<ConstraintGraph<Constraint<Variable> > > csp( cg, WORKERS );
+#elif defined(PORTFOLIO) //strategies racing on threads, see AddStrategies
+	Portfolio<ConstraintGraph<Constraint<Variable> > > csp( cg );
+	AddStrategies( csp );
+#else
+	CSP<ConstraintGraph<Constraint<Variable> > > csp( cg );
+#endif
+#ifdef ORDERING //MRV_DEGREE, DOM_DEG, DOM_WDEG, MAX_DEGREE
+		csp.SetVariableOrdering( CSP<ConstraintGraph<Constraint<Variable> > >::ORDERING );
+#endif
+#ifdef ENTAILMENT //constraints that cannot fail are skipped until backtracking
+		csp.SetEntailment( true );
+#endif
+#ifdef TABLES
+		csp.CompileBinaryConstraints();
+#endif
 		clock_t start = std::clock();
 		if ( 
 #ifdef ARC
 				csp.SolveARC(0) 
 #endif
+#ifdef PROP
+				csp.SolvePROP(0) 
+#endif
 #ifdef FC
 				csp.SolveFC(0) 
 #endif
@@ -452,6 +716,12 @@ int main () {
 #endif
 #ifdef DFScount
 				csp.SolveFC_count(0)
+#endif
+#ifdef ITERATIVE //no recursion, BACKTRACKING, FORWARD_CHECKING, ARC_CONSISTENCY, PROPAGATION
+				csp.SolveIterative( CSP<ConstraintGraph<Constraint<Variable> > >::ITERATIVE )
+#endif
+#ifdef PORTFOLIO
+				csp.Solve()
 #endif
 		   ) {
 			//cg.Print();
@@ -461,7 +731,7 @@ int main () {
 				<< csp.GetSolutionCounter() << std::endl;
 #else
 
-			for (int i=0;i<SIZE;++i) {
+			for (int i=0;i<SIZE && SIZE<=100;++i) {
 				for (int j=0;j<SIZE;++j) {
 					if ( j == array_of_variables[ i ]->GetValue() ) std::cout << " Q ";
 					else std::cout << " . ";
@@ -469,17 +739,41 @@ int main () {
 				std::cout << std::endl;
 			}
 			std::cout << std::endl;
+#endif
+#if defined(GLOBAL) && !defined(DFScount)
+			//the original constraint is not attached - recounts the queens
+			if ( array_of_constraints[0]->Check() ) std::cout << "Solution is correct\n";
+			else std::cout << "FAILED - some queens are attacking each other\n";
 #endif
 			std::cout << "Time " << static_cast<float>(finish-start)/CLOCKS_PER_SEC << std::endl;
 			std::cout << "RecursiveCallCounter = " 
 				<< csp.GetRecursiveCallCounter() << std::endl;
 			std::cout << "IterationCounter     = " 
 				<< csp.GetIterationCounter() << std::endl;
+#ifdef WORKERS
+			for (unsigned w=0;w<csp.NumWorkers();++w) {
+				std::cout << "Worker " << w << " RecursiveCallCounter = " << csp.GetRecursiveCallCounter(w) 
+#ifdef DFScount
+					<< " cubes " << csp.GetCubeCounter(w) << " solutions " << csp.GetSolutionCounter(w) 
+#endif
+					<< " steals " << csp.GetStealCounter(w) << std::endl;
+			}
+			std::cout << "Wall time " << csp.GetWallTime() << std::endl;
+			std::cout << "Speedup not measured - compare with the Wall time of a -DWORKERS=1 build" << std::endl;
+#endif
+#ifdef PORTFOLIO
+			for (unsigned s=0;s<csp.NumStrategies();++s) {
+				std::cout << "Strategy " << csp.GetName(s) << " RecursiveCallCounter = " << csp.GetRecursiveCallCounter(s) 
+					<< " wins " << csp.GetWinCounter(s) << std::endl;
+			}
+			std::cout << "Winner " << csp.GetName( csp.GetWinner() ) << std::endl;
+			std::cout << "Wall time " << csp.GetWallTime() << std::endl;
+#endif
 
 		}
 		else std::cout << "No solution found\n";
 
-		for (int i=0;i<SIZE*(SIZE-1);++i) delete array_of_constraints[i];
+		for (int i=0;i<NUM_CONSTRAINTS;++i) delete array_of_constraints[i];
 
 		for (int i=0;i<SIZE;++i) { delete array_of_variables[i]; }
 		delete [] array_of_variables;
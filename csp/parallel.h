@@ -0,0 +1,734 @@
+/******************************************************************************/
+/*!
+\file   parallel.h
+\brief
+  Solving on several threads over a shared ConstraintGraph: work-stealing
+  parallel search (SolveDFS, SolveFC) and counting (SolveFC_count), and
+  a portfolio racing differently configured solvers.
+  Variables, constraints and the graph hold the state of a search
+  (domains, observers, entailment, weights), so each thread searches
+  its own replica: copies of the variables with the constraints of
+  the shared graph cloned onto them (ConstraintGraph::Replicate). The
+  structure PreProcess built (rows, edges, batches) is not copied, all
+  replicas read the one of the shared graph. The shared graph is only
+  read.
+  Above the split depth a worker publishes the values of the variable
+  it branches on as open branches in its deque and takes them back from
+  the bottom, depth first as CSP does, while idle workers steal from the
+  top - the open branch nearest the root, the largest piece of work left.
+  A thief replays the decisions leading to the branch (assign and
+  propagate) and searches below it. Workers with nothing to steal
+  sleep until a branch is published or the search is over, so idle
+  threads do not take the deque locks of the busy ones. The first solution stops all
+  workers (CSP::SetInterrupt) and is assigned to the variables of the
+  shared graph.
+  Counting splits the search space into cubes instead - all ways
+  forward checking allows to fix the first k unassigned variables.
+  Workers take the next cube, count the solutions in it with
+  CSP::SolveFC_count, and the counts are added up.
+  A portfolio runs each strategy (solver and ordering) on a replica, 
+  the first one to finish decides and the others give up.
+  Needs C++11 threads.
+*/
+/******************************************************************************/
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include "csp.h"
+
+////////////////////////////////////////////////////////////
+//copy of a preprocessed graph searched by its own CSP: copies of
+//the variables (names, domains with their universe, assignments and
+//IDs) with the constraints cloned onto them
+template <typename T>
+struct Replica {
+	typedef typename T::Variable         Variable;
+	typedef typename T::Variable::Value  Value;
+	typedef typename T::Variable::Domain Domain;
+
+	explicit Replica(const T& shared);
+	~Replica();
+	//undo the search and take the domains and assignments of the
+	//shared variables again
+	void Reset(const T& shared);
+
+	std::vector<Variable*> vars;
+	T* cg;
+	CSP<T>* csp;
+	private:
+		//a copy would share the variables
+		Replica(const Replica&);
+		Replica& operator=(const Replica&);
+};
+
+template <typename T>
+class ParallelSearch : public Interrupt {
+		typedef typename T::Variable         Variable;
+		typedef typename T::Variable::Value  Value;
+		typedef typename T::Variable::Domain Domain;
+		typedef CSP<T> Solver;
+	public:
+		////////////////////////////////////////////////////////////
+		//ctor, builds a replica of the preprocessed graph for each of
+		//the workers (at least one)
+		ParallelSearch(T &cg, unsigned num_workers);
+		~ParallelSearch();
+
+		//settings of the CSP of each worker (see CSP)
+		void SetVariableOrdering(typename Solver::VariableOrdering o);
+		void SetEntailment(bool on);
+		void CompileBinaryConstraints();
+		//levels above this one publish their values, subtrees below
+		//are searched by one worker (default 8)
+		void SetSplitDepth(unsigned depth) { split_depth = depth; }
+		//variables fixed in each cube by SolveFC_count (default 4)
+		void SetCubeDepth(unsigned depth) { cube_depth = depth; }
+
+		//CSP solvers run by all workers, "level" has to be 0. The
+		//solution is assigned to the variables of the shared graph
+		bool SolveDFS(unsigned level);
+		bool SolveFC(unsigned level);
+		//CSP counting on all workers, "level" has to be 0 
+		bool SolveFC_count(unsigned level);
+
+		//counters summed over the workers
+		uint64_t GetSolutionCounter() const;
+		int GetRecursiveCallCounter() const;
+		int GetIterationCounter() const;
+		//counters of one worker: solutions, nodes, branches it stole
+		//and cubes it counted
+		unsigned NumWorkers() const { return workers.size(); }
+		uint64_t GetSolutionCounter(unsigned worker) const;
+		int GetRecursiveCallCounter(unsigned worker) const;
+		unsigned GetStealCounter(unsigned worker) const { return workers[worker]->steals; }
+		unsigned GetCubeCounter(unsigned worker) const { return workers[worker]->cubes; }
+		//wall-clock seconds of the last Solve (std::clock adds up
+		//the time of all threads)
+		double GetWallTime() const { return wall_time; }
+
+		//Interrupt - some worker found a solution
+		bool Requested() const { return found.load( std::memory_order_relaxed ); }
+	private:
+		//variable with ID "var" is assigned "val" at "level"
+		struct Decision {
+			unsigned level;
+			unsigned var;
+			Value    val;
+		};
+		struct Worker : Replica<T> {
+			explicit Worker(const T& shared) : Replica<T>(shared), 
+				open(), mutex(), path( shared.GetAllVariables().size() ), 
+				task(), values(), steals(0), cubes(0) {}
+			//a solution stops the other workers with branches still
+			//open, they must not leak into the next search
+			void Reset(const T& shared) {
+				Replica<T>::Reset(shared);
+				open.clear();
+				task.clear();
+			}
+			//open branches ordered by level, the one nearest the root
+			//in front, guarded by "mutex"
+			std::deque<Decision> open;
+			std::mutex mutex;
+			//decisions leading to the node being searched (by level),
+			//thieves copy the ones above the branch they take
+			std::vector<Decision> path;
+			//decisions leading to the branch to search next
+			std::vector<Decision> task;
+			//scratch for Publish
+			std::vector<Value> values;
+			unsigned steals, cubes;
+		};
+		//worker 0 takes the root, the others steal
+		bool Solve(bool forward_checking);
+		//run "work" on all workers - worker 0 on the calling thread
+		void Start(void (ParallelSearch::*work)(unsigned));
+		//thread of a worker - search branches until the search is over
+		void Run(unsigned i);
+		//thread of a worker - count cubes until none is left
+		void Count(unsigned i);
+		//fill "cubes" from the node of w at "level"
+		void Cubes(Worker& w, unsigned level);
+		//assign and propagate the decisions of w.task from the root,
+		//"level" is the number assigned (the failing one included)
+		bool Replay(Worker& w, unsigned& level);
+		//unassign the first "level" decisions of w.task and undo all
+		//back to the root
+		void Unwind(Worker& w, unsigned level);
+		//replay w.task and search below it, true if a solution was
+		//found (left assigned), otherwise all is undone
+		bool Execute(Worker& w);
+		//SolveDFS/SolveFC above the split depth
+		bool Branch(Worker& w, unsigned level);
+		//check (DFS) or forward check (FC) the assignment of x
+		bool Consistent(Worker& w, Variable* x) const;
+		//push the values of x as open branches at "level"
+		void Publish(Worker& w, unsigned level, Variable* x);
+		//take back the next value at "level", false if none is left
+		bool Pop(Worker& w, unsigned level, Value& val);
+		//take the open branch nearest the root from another worker
+		//into workers[i]->task
+		bool Steal(unsigned i);
+		//sleep until some branch is open or the search is over
+		void Wait();
+		//wake the sleeping workers up after the state Wait checks
+		//has changed
+		void Wake();
+		//a copy would share the workers
+		ParallelSearch(const ParallelSearch&);
+		ParallelSearch& operator=(const ParallelSearch&);
+
+		T& cg;
+		std::vector<Worker*> workers;
+		unsigned split_depth;
+		bool forward_checking;
+		//cubes of SolveFC_count, "cube_size" decisions each, and the
+		//next one to take
+		unsigned cube_depth, cube_size;
+		std::vector<Decision> cubes;
+		std::atomic<unsigned> next_cube;
+		//workers searching a branch, stolen branches are counted
+		//before they leave the deque, so 0 means no work is left
+		std::atomic<unsigned> busy;
+		std::atomic<bool> found;
+		//branches in all the deques, and workers in Wait
+		std::atomic<unsigned> open_branches, sleeping;
+		std::mutex idle_mutex;
+		std::condition_variable idle;
+		unsigned winner;
+		double wall_time;
+};
+
+////////////////////////////////////////////////////////////
+template <typename T>
+Replica<T>::Replica(const T& shared) : vars(), cg(0), csp(0) {
+	const std::vector<Variable*>& all_vars = shared.GetAllVariables();
+	typename std::vector<Variable*>::const_iterator b_vars = all_vars.begin();
+	typename std::vector<Variable*>::const_iterator e_vars = all_vars.end();
+	for ( ; b_vars!=e_vars; ++b_vars ) {
+		const Domain& dom = (*b_vars)->GetDomain();
+		std::vector<Value> values( dom.begin(), dom.end() );
+		Variable* copy = new Variable( (*b_vars)->Name(), values, dom.GetRepresentation() );
+		copy->SetDomain( dom );
+		if ( (*b_vars)->IsAssigned() ) copy->Assign( (*b_vars)->GetValue() );
+		vars.push_back( copy );
+	}
+	cg = new T;
+	cg->Replicate( shared, vars );
+	csp = new CSP<T>( *cg );
+}
+
+////////////////////////////////////////////////////////////
+//the CSP does not touch the graph or variables when destroyed,
+//the graph deletes its constraints
+template <typename T>
+Replica<T>::~Replica() {
+	delete csp;
+	delete cg;
+	for ( unsigned x=0; x<vars.size(); ++x ) delete vars[x];
+}
+
+////////////////////////////////////////////////////////////
+//as a solver backtracks - unassign, then undo the trail
+template <typename T>
+void Replica<T>::Reset(const T& shared) {
+	for ( unsigned x=0; x<vars.size(); ++x ) {
+		if ( vars[x]->IsAssigned() ) vars[x]->UnAssign();
+	}
+	cg->RestoreEntailed(0);
+	csp->trail.Undo(0);
+	const std::vector<Variable*>& shared_vars = shared.GetAllVariables();
+	for ( unsigned x=0; x<vars.size(); ++x ) {
+		vars[x]->SetDomain( shared_vars[x]->GetDomain() );
+		if ( shared_vars[x]->IsAssigned() ) vars[x]->Assign( shared_vars[x]->GetValue() );
+	}
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+ParallelSearch<T>::ParallelSearch(T &cg, unsigned num_workers) :
+	cg(cg), workers(), split_depth(8), forward_checking(true),
+	cube_depth(4), cube_size(0), cubes(), next_cube(0),
+	busy(0), found(false), open_branches(0), sleeping(0), idle_mutex(), idle(),
+	winner(0), wall_time(0)
+{
+	for ( unsigned i=0; i<num_workers || i==0; ++i ) {
+		workers.push_back( new Worker(cg) );
+		workers.back()->csp->SetInterrupt( this );
+	}
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+ParallelSearch<T>::~ParallelSearch() {
+	for ( unsigned i=0; i<workers.size(); ++i ) delete workers[i];
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+void ParallelSearch<T>::SetVariableOrdering(typename Solver::VariableOrdering o) {
+	for ( unsigned i=0; i<workers.size(); ++i ) workers[i]->csp->SetVariableOrdering(o);
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+void ParallelSearch<T>::SetEntailment(bool on) {
+	for ( unsigned i=0; i<workers.size(); ++i ) workers[i]->csp->SetEntailment(on);
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+void ParallelSearch<T>::CompileBinaryConstraints() {
+	for ( unsigned i=0; i<workers.size(); ++i ) workers[i]->csp->CompileBinaryConstraints();
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+bool ParallelSearch<T>::SolveDFS(unsigned) {
+	return Solve(false);
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+bool ParallelSearch<T>::SolveFC(unsigned) {
+	return Solve(true);
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+uint64_t ParallelSearch<T>::GetSolutionCounter() const {
+	uint64_t result = 0;
+	for ( unsigned i=0; i<workers.size(); ++i ) result += workers[i]->csp->GetSolutionCounter();
+	return result;
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+int ParallelSearch<T>::GetRecursiveCallCounter() const {
+	int result = 0;
+	for ( unsigned i=0; i<workers.size(); ++i ) result += workers[i]->csp->GetRecursiveCallCounter();
+	return result;
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+int ParallelSearch<T>::GetIterationCounter() const {
+	int result = 0;
+	for ( unsigned i=0; i<workers.size(); ++i ) result += workers[i]->csp->GetIterationCounter();
+	return result;
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+uint64_t ParallelSearch<T>::GetSolutionCounter(unsigned worker) const {
+	return workers[worker]->csp->GetSolutionCounter();
+}
+////////////////////////////////////////////////////////////
+template <typename T>
+int ParallelSearch<T>::GetRecursiveCallCounter(unsigned worker) const {
+	return workers[worker]->csp->GetRecursiveCallCounter();
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+bool ParallelSearch<T>::Solve(bool fc) {
+	std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+	for ( unsigned i=0; i<workers.size(); ++i ) workers[i]->Reset(cg);
+	forward_checking = fc;
+	found = false;
+	busy = 1;
+	open_branches = 0;
+	Start( &ParallelSearch::Run );
+	wall_time = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	if ( !found ) return false;
+
+	const std::vector<Variable*>& all_vars = cg.GetAllVariables();
+	for ( unsigned x=0; x<all_vars.size(); ++x ) {
+		if ( !all_vars[x]->IsAssigned() ) all_vars[x]->Assign( workers[winner]->vars[x]->GetValue() );
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////
+//cubes are made by worker 0 before the others start
+template <typename T>
+bool ParallelSearch<T>::SolveFC_count(unsigned) {
+	std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+	for ( unsigned i=0; i<workers.size(); ++i ) workers[i]->Reset(cg);
+	found = false;
+	Worker& w = *workers[0];
+	unsigned unassigned = 0;
+	for ( unsigned x=0; x<w.vars.size(); ++x ) {
+		if ( !w.vars[x]->IsAssigned() ) ++unassigned;
+	}
+	cube_size = std::min( cube_depth, unassigned );
+	cubes.clear();
+	Cubes( w, 0 );
+	next_cube = 0;
+	uint64_t const before = GetSolutionCounter();
+	Start( &ParallelSearch::Count );
+	wall_time = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	return GetSolutionCounter() > before;
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+void ParallelSearch<T>::Start(void (ParallelSearch::*work)(unsigned)) {
+	std::vector<std::thread> threads;
+	for ( unsigned i=1; i<workers.size(); ++i ) {
+		threads.push_back( std::thread( work, this, i ) );
+	}
+	(this->*work)(0);
+	for ( unsigned i=0; i<threads.size(); ++i ) threads[i].join();
+}
+
+////////////////////////////////////////////////////////////
+//the search is over when a solution is found or no worker is
+//busy (then no branch is open)
+template <typename T>
+void ParallelSearch<T>::Run(unsigned i) {
+	Worker& w = *workers[i];
+	bool has_branch = ( i == 0 );
+	for ( ;; ) {
+		if ( has_branch ) {
+			if ( Execute(w) ) {
+				bool expected = false;
+				if ( found.compare_exchange_strong( expected, true ) ) winner = i;
+				Wake();
+			}
+			if ( --busy == 0 ) Wake();
+		}
+		if ( found ) return;
+		has_branch = Steal(i);
+		if ( !has_branch ) {
+			if ( busy == 0 ) return;
+			Wait();
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////
+//cubes are taken in order (one empty cube if nothing is fixed),
+//the solutions stay in the counter of the worker's CSP
+template <typename T>
+void ParallelSearch<T>::Count(unsigned i) {
+	Worker& w = *workers[i];
+	for ( ;; ) {
+		unsigned const cube = next_cube++;
+		if ( cube_size ? cube >= cubes.size() / cube_size : cube > 0 ) return;
+		w.task.assign( cubes.begin() + cube*cube_size, cubes.begin() + (cube+1)*cube_size );
+		++w.cubes;
+		unsigned level = 0;
+		if ( Replay( w, level ) ) w.csp->SolveFC_count( level );
+		Unwind( w, level );
+	}
+}
+
+////////////////////////////////////////////////////////////
+//the lowest unassigned ID is fixed at each level, a cube is the
+//path to a node at cube_size
+template <typename T>
+void ParallelSearch<T>::Cubes(Worker& w, unsigned level) {
+	if ( level == cube_size ) {
+		cubes.insert( cubes.end(), w.path.begin(), w.path.begin() + level );
+		return;
+	}
+	unsigned id = 0;
+	while ( w.vars[id]->IsAssigned() ) ++id;
+	Variable* x = w.vars[id];
+	unsigned const checkpoint = w.csp->trail.Checkpoint();
+	unsigned const entailed = w.cg->NumEntailed();
+	//only unassigned variables are pruned, so domain is not modified
+	Domain const& domain = x->GetDomain();
+	typename Domain::const_iterator b_dom = domain.begin();
+	typename Domain::const_iterator e_dom = domain.end();
+	for ( ; b_dom!=e_dom; ++b_dom ) {
+		w.path[level].level = level;
+		w.path[level].var = id;
+		w.path[level].val = *b_dom;
+		x->Assign(*b_dom);
+		if ( w.csp->ForwardChecking(x) ) Cubes( w, level+1 );
+		x->UnAssign();
+		w.cg->RestoreEntailed(entailed);
+		w.csp->trail.Undo(checkpoint);
+	}
+}
+
+////////////////////////////////////////////////////////////
+//the worker starts at the root: all variables filed, empty trail
+template <typename T>
+bool ParallelSearch<T>::Replay(Worker& w, unsigned& level) {
+	Solver& csp = *w.csp;
+	csp.buckets.Init( w.cg->GetAllVariables() );
+	bool consistent = true;
+	for ( level=0; level<w.task.size() && consistent; ++level ) {
+		Variable* x = w.vars[ w.task[level].var ];
+		w.path[level] = w.task[level];
+		csp.buckets.Remove(x);
+		unsigned const checkpoint = csp.trail.Checkpoint();
+		x->Assign( w.task[level].val );
+		consistent = Consistent( w, x );
+		if ( consistent ) csp.UpdateBuckets(checkpoint);
+	}
+	return consistent;
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+void ParallelSearch<T>::Unwind(Worker& w, unsigned level) {
+	while ( level ) w.vars[ w.task[--level].var ]->UnAssign();
+	w.cg->RestoreEntailed(0);
+	w.csp->trail.Undo(0);
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+bool ParallelSearch<T>::Execute(Worker& w) {
+	unsigned level = 0;
+	if ( Replay( w, level ) && Branch( w, level ) ) return true;
+	Unwind( w, level );
+	return false;
+}
+
+////////////////////////////////////////////////////////////
+//as CSP::SolveFC/SolveDFS, but the values are published and taken
+//back one by one (the rest may be stolen meanwhile)
+template <typename T>
+bool ParallelSearch<T>::Branch(Worker& w, unsigned level) {
+	Solver& csp = *w.csp;
+	if ( level >= split_depth ) {
+		return forward_checking ? csp.SolveFC(level) : csp.SolveDFS(level);
+	}
+	if ( Requested() ) return false;
+	++csp.recursive_call_counter;
+	if ( csp.buckets.NumUnassigned() == 0 ) return true;
+
+	Variable* x = csp.SelectVariable();
+	csp.buckets.Remove(x);
+	unsigned const checkpoint = csp.trail.Checkpoint();
+	unsigned const entailed = w.cg->NumEntailed();
+	Publish( w, level, x );
+	Value val;
+	while ( Pop( w, level, val ) ) {
+		++csp.iteration_counter;
+		w.path[level].level = level;
+		w.path[level].var = x->ID();
+		w.path[level].val = val;
+		x->Assign(val);
+		if ( Consistent( w, x ) ) {
+			csp.UpdateBuckets(checkpoint);
+			if ( Branch( w, level+1 ) ) return true;
+		}
+		x->UnAssign();
+		csp.Backtrack(checkpoint, entailed);
+	}
+	csp.buckets.Insert(x);
+	return false;
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+bool ParallelSearch<T>::Consistent(Worker& w, Variable* x) const {
+	return forward_checking ? w.csp->ForwardChecking(x) : w.csp->AssignmentIsConsistent(x);
+}
+
+////////////////////////////////////////////////////////////
+//pushed in reverse, so the owner takes them in domain order
+//and thieves take the last ones
+template <typename T>
+void ParallelSearch<T>::Publish(Worker& w, unsigned level, Variable* x) {
+	w.values.assign( x->GetDomain().begin(), x->GetDomain().end() );
+	Decision d;
+	d.level = level;
+	d.var = x->ID();
+	std::lock_guard<std::mutex> lock( w.mutex );
+	typename std::vector<Value>::const_reverse_iterator b_v = w.values.rbegin();
+	typename std::vector<Value>::const_reverse_iterator e_v = w.values.rend();
+	for ( ; b_v!=e_v; ++b_v ) {
+		d.val = *b_v;
+		w.open.push_back(d);
+	}
+	open_branches += w.values.size();
+	Wake();
+}
+
+////////////////////////////////////////////////////////////
+//deeper levels are done when the owner is back at "level", so
+//a bottom entry of a lower level means level is exhausted
+template <typename T>
+bool ParallelSearch<T>::Pop(Worker& w, unsigned level, Value& val) {
+	std::lock_guard<std::mutex> lock( w.mutex );
+	if ( w.open.empty() || w.open.back().level != level ) return false;
+	val = w.open.back().val;
+	w.open.pop_back();
+	--open_branches;
+	return true;
+}
+
+////////////////////////////////////////////////////////////
+//the victim does not leave the levels above an open branch, so
+//its decisions there are stable while the branch is in the deque
+template <typename T>
+bool ParallelSearch<T>::Steal(unsigned i) {
+	Worker& thief = *workers[i];
+	for ( unsigned k=1; k<workers.size(); ++k ) {
+		Worker& victim = *workers[ (i+k) % workers.size() ];
+		std::lock_guard<std::mutex> lock( victim.mutex );
+		if ( victim.open.empty() ) continue;
+		Decision const d = victim.open.front();
+		victim.open.pop_front();
+		--open_branches;
+		thief.task.assign( victim.path.begin(), victim.path.begin() + d.level );
+		thief.task.push_back(d);
+		++busy;
+		++thief.steals;
+		return true;
+	}
+	return false;
+}
+
+////////////////////////////////////////////////////////////
+//the state is checked with idle_mutex held, and Wake takes it
+//whenever a worker may be in Wait, so no wakeup is missed
+template <typename T>
+void ParallelSearch<T>::Wait() {
+	std::unique_lock<std::mutex> lock( idle_mutex );
+	++sleeping;
+	while ( open_branches == 0 && busy != 0 && !found ) idle.wait( lock );
+	--sleeping;
+}
+
+////////////////////////////////////////////////////////////
+//nothing to do (no lock, no system call) while all are busy
+template <typename T>
+void ParallelSearch<T>::Wake() {
+	if ( sleeping == 0 ) return;
+	{ std::lock_guard<std::mutex> lock( idle_mutex ); }
+	idle.notify_all();
+}
+
+////////////////////////////////////////////////////////////
+//strategies racing on their own replicas
+template <typename T>
+class Portfolio : public Interrupt {
+		typedef typename T::Variable Variable;
+		typedef CSP<T> Solver;
+	public:
+		//solver run by a strategy - &CSP<T>::SolveFC, ...
+		typedef bool (Solver::*Algorithm)(unsigned);
+		////////////////////////////////////////////////////////////
+		explicit Portfolio(T &cg);
+		~Portfolio();
+		//add a strategy searching its own replica of the graph, the
+		//returned CSP may be configured further (SetArcRevision, ...)
+		Solver& AddStrategy(const std::string& name, Algorithm algorithm,
+				typename Solver::VariableOrdering ordering);
+
+		//race the strategies (at least one) from the domains and 
+		//assignments of the shared variables: the first one to finish
+		//decides - its solution is assigned to the shared variables -
+		//and the others give up
+		bool Solve();
+
+		unsigned NumStrategies() const { return strategies.size(); }
+		const std::string& GetName(unsigned s) const { return strategies[s]->name; }
+		//races the strategy decided
+		unsigned GetWinCounter(unsigned s) const { return strategies[s]->wins; }
+		//counters of the strategy, over all races
+		int GetRecursiveCallCounter(unsigned s) const { return strategies[s]->csp->GetRecursiveCallCounter(); }
+		//strategy that decided the last race and its counters
+		unsigned GetWinner() const { return winner; }
+		int GetRecursiveCallCounter() const { return GetRecursiveCallCounter(winner); }
+		int GetIterationCounter() const { return strategies[winner]->csp->GetIterationCounter(); }
+		//wall-clock seconds of the last race
+		double GetWallTime() const { return wall_time; }
+
+		//Interrupt - some strategy finished
+		bool Requested() const { return decided.load( std::memory_order_relaxed ); }
+	private:
+		struct Strategy : Replica<T> {
+			Strategy(const T& shared, const std::string& name, Algorithm algorithm) :
+				Replica<T>(shared), name(name), algorithm(algorithm), wins(0) {}
+			std::string name;
+			Algorithm algorithm;
+			unsigned wins;
+		};
+		//thread of a strategy
+		void Run(unsigned s);
+		//a copy would share the strategies
+		Portfolio(const Portfolio&);
+		Portfolio& operator=(const Portfolio&);
+
+		T& cg;
+		std::vector<Strategy*> strategies;
+		std::atomic<bool> decided;
+		unsigned winner;
+		bool solved;
+		double wall_time;
+};
+
+////////////////////////////////////////////////////////////
+template <typename T>
+Portfolio<T>::Portfolio(T &cg) :
+	cg(cg), strategies(), decided(false), winner(0), solved(false), wall_time(0)
+{}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+Portfolio<T>::~Portfolio() {
+	for ( unsigned s=0; s<strategies.size(); ++s ) delete strategies[s];
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+typename Portfolio<T>::Solver& Portfolio<T>::AddStrategy(const std::string& name, 
+		Algorithm algorithm, typename Solver::VariableOrdering ordering) {
+	strategies.push_back( new Strategy( cg, name, algorithm ) );
+	Solver& csp = *strategies.back()->csp;
+	csp.SetVariableOrdering( ordering );
+	csp.SetInterrupt( this );
+	return csp;
+}
+
+////////////////////////////////////////////////////////////
+//the calling thread runs strategy 0
+template <typename T>
+bool Portfolio<T>::Solve() {
+	std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+	for ( unsigned s=0; s<strategies.size(); ++s ) strategies[s]->Reset(cg);
+	decided = false;
+	std::vector<std::thread> threads;
+	for ( unsigned s=1; s<strategies.size(); ++s ) {
+		threads.push_back( std::thread( &Portfolio::Run, this, s ) );
+	}
+	Run(0);
+	for ( unsigned i=0; i<threads.size(); ++i ) threads[i].join();
+	wall_time = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+	Strategy& w = *strategies[winner];
+	++w.wins;
+	if ( !solved ) return false;
+	const std::vector<Variable*>& all_vars = cg.GetAllVariables();
+	for ( unsigned x=0; x<all_vars.size(); ++x ) {
+		if ( !all_vars[x]->IsAssigned() ) all_vars[x]->Assign( w.vars[x]->GetValue() );
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////
+//a solver gives up only after some strategy finished, so the first
+//one to finish was not interrupted - "no solution" is an answer too
+template <typename T>
+void Portfolio<T>::Run(unsigned s) {
+	Strategy& st = *strategies[s];
+	bool const result = ( st.csp->*st.algorithm )( 0 );
+	bool expected = false;
+	if ( decided.compare_exchange_strong( expected, true ) ) {
+		winner = s;
+		solved = result;
+	}
+}
+
+#endif
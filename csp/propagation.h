@@ -0,0 +1,192 @@
+/******************************************************************************/
+/*!
+\file   propagation.h
+\brief
+  Event driven propagation to a fixpoint.
+  Each constraint subscribes to events on its variables (Constraint::Events):
+  a variable being assigned (fixed), a change of its bounds, or any
+  removal. After a decision the scheduler wakes the constraints of the
+  assigned variable, runs them cheapest first (Constraint::Priority),
+  and looks at the trail to see which variables lost values and whether
+  their bounds moved. Only constraints subscribed to those events are
+  queued again, until nothing changes or a domain becomes empty.
+*/
+/******************************************************************************/
+#ifndef PROPAGATION_H
+#define PROPAGATION_H
+#include <vector>
+#include "trail.h"
+
+template <typename T>
+class Scheduler {
+		typedef typename T::Constraint      Constraint;
+		typedef typename T::Variable        Variable;
+		typedef typename T::Variable::Value Value;
+	public:
+		////////////////////////////////////////////////////////////
+		Scheduler(T& cg, Trail& trail);
+		////////////////////////////////////////////////////////////
+		//propagate the assignment of x to a fixpoint, returns false
+		//if some domain became empty (the failing constraint gets
+		//its weight incremented)
+		bool Propagate(Variable* x);
+	private:
+		enum { NUM_PRIORITIES = 3 };
+		//build wakeup lists from the constraints of each variable
+		void Init();
+		//queue constraints subscribed to the events on var
+		void Schedule(unsigned var, unsigned events);
+		//events of variables that lost values since the checkpoint,
+		//ON_FIXED for those left with a single value
+		void ScheduleChanges(unsigned checkpoint);
+		//empty all queues after a failure
+		void Clear();
+
+		T& cg;
+		Trail& trail;
+		//wakeup lists: constraints (IDs) of each variable
+		//subscribed to ON_FIXED, ON_BOUNDS and ON_REMOVED
+		std::vector< std::vector<unsigned> > on_fixed, on_bounds, on_removed;
+		//FIFO of constraint IDs for each priority
+		std::vector<unsigned> queue[NUM_PRIORITIES];
+		unsigned head[NUM_PRIORITIES];
+		std::vector<bool> queued;
+		//changed variables found by ScheduleChanges, their events
+		//and stamps to collect each variable once
+		std::vector<unsigned> changed;
+		std::vector<unsigned> events;
+		std::vector<unsigned> stamp;
+		unsigned current_stamp;
+};
+
+////////////////////////////////////////////////////////////
+template <typename T>
+Scheduler<T>::Scheduler(T& cg, Trail& trail) :
+	cg(cg), trail(trail), on_fixed(), on_bounds(), on_removed(),
+	queued(), changed(), events(), stamp(), current_stamp(0)
+{
+	for ( unsigned p=0; p<NUM_PRIORITIES; ++p ) head[p] = 0;
+}
+
+////////////////////////////////////////////////////////////
+//wakeup lists are built from GetConstraints (var2constr)
+template <typename T>
+void Scheduler<T>::Init() {
+	const std::vector<Variable*>& vars = cg.GetAllVariables();
+	on_fixed.assign( vars.size(), std::vector<unsigned>() );
+	on_bounds.assign( vars.size(), std::vector<unsigned>() );
+	on_removed.assign( vars.size(), std::vector<unsigned>() );
+	for ( unsigned x=0; x<vars.size(); ++x ) {
+		typename T::ConstraintRange const constr = cg.GetConstraints( vars[x] );
+		typename T::ConstraintRange::const_iterator b_c = constr.begin();
+		typename T::ConstraintRange::const_iterator e_c = constr.end();
+		for ( ; b_c!=e_c; ++b_c ) {
+			switch ( (*b_c)->Events() ) {
+				case Constraint::ON_FIXED:  on_fixed[x].push_back( b_c.ID() ); break;
+				case Constraint::ON_BOUNDS: on_bounds[x].push_back( b_c.ID() ); break;
+				default:                    on_removed[x].push_back( b_c.ID() ); break;
+			}
+		}
+	}
+	queued.assign( cg.NumConstraints(), false );
+	events.assign( vars.size(), 0 );
+	stamp.assign( vars.size(), 0 );
+	current_stamp = 0;
+}
+
+////////////////////////////////////////////////////////////
+//an event wakes up constraints subscribed to it or to a weaker one
+//(a bounds change is also a removal, assignment is both)
+template <typename T>
+void Scheduler<T>::Schedule(unsigned var, unsigned ev) {
+	const std::vector<unsigned>* lists[3] = { &on_removed[var], &on_bounds[var], &on_fixed[var] };
+	unsigned num_lists =
+		( ev & Constraint::ON_FIXED )  ? 3 :
+		( ev & Constraint::ON_BOUNDS ) ? 2 : 1;
+	for ( unsigned l=0; l<num_lists; ++l ) {
+		std::vector<unsigned>::const_iterator b_c = lists[l]->begin();
+		std::vector<unsigned>::const_iterator e_c = lists[l]->end();
+		for ( ; b_c!=e_c; ++b_c ) {
+			if ( queued[*b_c] ) continue;
+			queued[*b_c] = true;
+			unsigned p = cg.GetConstraint(*b_c)->Priority();
+			queue[ p < NUM_PRIORITIES ? p : NUM_PRIORITIES-1 ].push_back( *b_c );
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////
+//a removed value outside of the current [min,max] means
+//that a bound has moved, a single value left means that the
+//variable is fixed even though it is not assigned
+template <typename T>
+void Scheduler<T>::ScheduleChanges(unsigned checkpoint) {
+	++current_stamp;
+	changed.clear();
+	unsigned const end = trail.Checkpoint();
+	for ( unsigned i=checkpoint; i<end; ++i ) {
+		Variable* var = trail.GetVariable(i);
+		unsigned x = var->ID();
+		if ( stamp[x] != current_stamp ) {
+			stamp[x] = current_stamp;
+			events[x] = Constraint::ON_REMOVED;
+			changed.push_back( x );
+		}
+		if ( !( events[x] & Constraint::ON_BOUNDS ) ) {
+			Value val = trail.GetValue(i);
+			if ( val < var->GetMinValue() || val > var->GetMaxValue() ) {
+				events[x] |= Constraint::ON_BOUNDS;
+			}
+		}
+	}
+	std::vector<unsigned>::const_iterator b_x = changed.begin();
+	std::vector<unsigned>::const_iterator e_x = changed.end();
+	for ( ; b_x!=e_x; ++b_x ) {
+		if ( cg.GetAllVariables()[*b_x]->SizeDomain() == 1 ) {
+			events[*b_x] |= Constraint::ON_FIXED;
+		}
+		Schedule( *b_x, events[*b_x] );
+	}
+}
+
+////////////////////////////////////////////////////////////
+template <typename T>
+void Scheduler<T>::Clear() {
+	for ( unsigned p=0; p<NUM_PRIORITIES; ++p ) {
+		std::vector<unsigned>::const_iterator b_c = queue[p].begin() + head[p];
+		std::vector<unsigned>::const_iterator e_c = queue[p].end();
+		for ( ; b_c!=e_c; ++b_c ) queued[*b_c] = false;
+		queue[p].clear();
+		head[p] = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////
+//run queued constraints, lowest priority class first, and queue
+//constraints woken by their removals, until all queues are empty
+template <typename T>
+bool Scheduler<T>::Propagate(Variable* x) {
+	if ( queued.size() != cg.NumConstraints() ) Init();
+
+	Schedule( x->ID(), Constraint::ON_FIXED );
+	for ( ;; ) {
+		unsigned p = 0;
+		while ( p<NUM_PRIORITIES && head[p] == queue[p].size() ) ++p;
+		if ( p == NUM_PRIORITIES ) break;
+
+		unsigned c = queue[p][ head[p]++ ];
+		if ( head[p] == queue[p].size() ) { queue[p].clear(); head[p] = 0; }
+		queued[c] = false;
+
+		unsigned const checkpoint = trail.Checkpoint();
+		if ( ! cg.GetConstraint(c)->Propagate() ) {
+			cg.IncrementWeight(c);
+			Clear();
+			return false;
+		}
+		if ( trail.Checkpoint() != checkpoint ) ScheduleChanges( checkpoint );
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,55 @@
+/******************************************************************************/
+/*!
+\file   trail.h
+\brief
+  Undo log of domain changes used for backtracking.
+  A Variable attached to a trail records every value it loses in
+  Variable::RemoveValue. Search saves a checkpoint (current size of
+  the trail) before trying a value and undoes back to the checkpoint
+  afterwards, so restoring costs as much as the pruning that happened
+  since the checkpoint, not as much as all domains together.
+*/
+/******************************************************************************/
+#ifndef TRAIL_H
+#define TRAIL_H
+#include <vector>
+#include "variable.h"
+
+class Trail {
+	public:
+		////////////////////////////////////////////////////////////
+		Trail() : entries() {}
+		////////////////////////////////////////////////////////////
+		//current position in the log - pass it to Undo to return
+		//to the current state
+		unsigned Checkpoint() const { return entries.size(); }
+		////////////////////////////////////////////////////////////
+		//variable of the entry at the given position (< Checkpoint())
+		Variable* GetVariable(unsigned pos) const { return entries[pos].var; }
+		//value of the entry at the given position (< Checkpoint())
+		Variable::Value GetValue(unsigned pos) const { return entries[pos].val; }
+		////////////////////////////////////////////////////////////
+		//log removal of value "val" from the domain of "var"
+		void Record(Variable* var, Variable::Value val) {
+			entries.push_back( Entry(var,val) );
+		}
+		////////////////////////////////////////////////////////////
+		//restore all values removed after the checkpoint, most
+		//recent first
+		void Undo(unsigned checkpoint) {
+			while ( entries.size() > checkpoint ) {
+				const Entry& e = entries.back();
+				e.var->RestoreValue( e.val );
+				entries.pop_back();
+			}
+		}
+	private:
+		struct Entry {
+			Variable*       var;
+			Variable::Value val;
+			Entry(Variable* var, Variable::Value val) : var(var), val(val) {}
+		};
+		std::vector<Entry> entries;
+};
+
+#endif
@@ -16,14 +16,21 @@ unsigned Variable::nextid=0;
 		a string specifying symbol/name
 	\param av 
 		domain of the variable
+	\param rep 
+		representation of the domain (set, bitset or sparse set), 
+		by default bitset is used for dense ranges of values and
+		sparse set for everything else
 */
 /******************************************************************************/
-Variable::Variable ( const std::string & name, const std::vector<Value> & av ) : 
+Variable::Variable ( const std::string & name, const std::vector<Value> & av,
+		Domain::Representation rep ) : 
 	name(name),
-	domain (av.begin(),av.end()),
+	domain (av,rep),
 	assigned_value(Value()),
 	is_assigned(false),
-	id(++nextid) 
+	id(++nextid),
+	trail(0),
+	observers()
 {}
 
 /******************************************************************************/
@@ -32,8 +39,8 @@ Variable::Variable ( const std::string & name, const std::vector<Value> & av ) :
 */
 /******************************************************************************/
 std::ostream& operator<<(std::ostream& os, const Variable& v) {
-	std::set<Variable::Value>::const_iterator b = v.GetDomain().begin();
-	std::set<Variable::Value>::const_iterator e = v.GetDomain().end();
+	Variable::Domain::const_iterator b = v.GetDomain().begin();
+	Variable::Domain::const_iterator e = v.GetDomain().end();
 	os << "Variable \"" << v.Name() << "\" available values: ";
 	for ( ;b!=e;++b) { os << *b << " "; }
 	if ( v.IsAssigned() ) 
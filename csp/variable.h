@@ -7,7 +7,13 @@
 \brief  
   Class representing a variable for Constraint Satisfaction Problem.
   Implements domain, assigned/not assigned state.
-  Variable has a name and a unique id (id is not currently used)
+  Variable has a name and an id, ConstraintGraph renumbers ids densely
+  (0,1,2,...) so that they can be used as indices
+  Domain is stored in IntDomain (see domain.h), the representation 
+  (set, bitset or sparse set) can be chosen per variable.
+  If a Trail is attached, removed values are logged for backtracking.
+  Observers (e.g. SumEqual keeping running sums of bounds) are notified
+  after every change that may move the bounds.
   
 */
 /******************************************************************************/
@@ -18,7 +24,8 @@
   \brief  
   Class representing a variable for Constraint Satisfaction Problem.
   Implements domain, assigned/not assigned state.
-  Variable has a name and a unique id (id is not currently used)
+  Variable has a name and an id, ConstraintGraph renumbers ids densely
+  (0,1,2,...) so that they can be used as indices
 
     Operations include:
 
@@ -38,6 +45,11 @@
 #include <set>
 #include <fstream>
 #include <string>
+#include <utility>
+#include "domain.h"
+
+class Trail;
+class BoundsObserver;
 
 
 class VariableException : public std::exception {
@@ -52,6 +64,10 @@ class Variable {
 	public:
 		//! variable has to specify it's value type - used by other classes 
 		typedef int Value;
+		//! type of the collection of available values
+		typedef IntDomain Domain;
+		//! interface of objects watching the bounds
+		typedef BoundsObserver Observer;
 
 	private:
 		static unsigned nextid;
@@ -60,7 +76,7 @@ class Variable {
 		std::string name;
 
 		//! all remaining available values
-		std::set<Value> domain;
+		Domain domain;
 
 		//! currently assigned value (invalid if is_assigned == false)
 		Value assigned_value; 
@@ -68,18 +84,37 @@ class Variable {
 		//! validity of the assigned_value 
 		bool is_assigned; 
 
-		//! unique ID (not used)
+		//! unique ID, index of the variable once inserted into a ConstraintGraph
 		unsigned id;
 
+		//! log of removed values, may be NULL
+		Trail* trail;
+
+		//! objects watching the bounds and their tags
+		std::vector< std::pair<Observer*,unsigned> > observers;
+
+		friend class Trail;
+		void  RestoreValue(Value val);
+		void  NotifyRemoved(Value val);
+		void  NotifyRestored(Value val);
+		void  Notify();
+
 	public:
-		Variable ( const std::string & name, const std::vector<Value> & av );
+		Variable ( const std::string & name, const std::vector<Value> & av,
+				Domain::Representation rep = Domain::AUTO );
 		const std::string & Name() const;
 		void  RemoveValue(Value val);
 		void  SetDomain(const std::set<Value>& vals);
+		void  SetDomain(const Domain& vals);
 		int   SizeDomain() const;
-		const std::set<Value>& GetDomain() const;
+		const Domain& GetDomain() const;
 		bool  IsImpossible() const;
 		unsigned ID() const;
+		void  SetID(unsigned new_id);
+		void  SetTrail(Trail* t);
+		Trail* GetTrail() const;
+		void  AddObserver(Observer* o, unsigned tag);
+		void  RemoveObserver(Observer* o);
 		bool  IsAssigned() const;
 		void  Assign(Value val);
 		void  Assign();
@@ -90,6 +125,26 @@ class Variable {
 		void  Print() const;
 };
 
+/******************************************************************************/
+/*!
+  \class BoundsObserver
+  \brief  
+  Interface for objects keeping track of the bounds of variables, see
+  Variable::AddObserver. "tag" is the number given to AddObserver.
+  Removed/Restored are called after a single value left/returned to the
+  domain (the domain may be empty at that point), Changed after 
+  assignment, unassignment and SetDomain.
+*/
+/******************************************************************************/
+class BoundsObserver {
+	public:
+		virtual ~BoundsObserver() {}
+		virtual void Removed(Variable* var, unsigned tag, Variable::Value val) = 0;
+		virtual void Restored(Variable* var, unsigned tag, Variable::Value val) = 0;
+		virtual void Changed(Variable* var, unsigned tag) = 0;
+};
+
+
 std::ostream& operator<<(std::ostream& os, const Variable& v);
 
 #ifdef INLINE_VARIABLE
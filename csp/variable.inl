@@ -5,10 +5,11 @@
 #endif
 
 #include <iostream>
+#include "trail.h"
 
 /******************************************************************************/
 /*!
-	Remove value from the domain
+	Remove value from the domain, removal is logged in the attached trail
 	\param val
 		value to be removed
 	\exception VariableException 
@@ -17,14 +18,52 @@
 /******************************************************************************/
 INLINE void Variable::RemoveValue(Value val) {
 	//check value is in domain
-	std::set<Value>::iterator it = domain.find(val);
-	if ( it != domain.end() ) {
-		domain.erase(it);
-	}
-	else {
+	if ( !domain.Remove(val) ) {
 		throw VariableException("Variable::RemoveValue - value is not in the domain");
 	}
-
+	if ( trail ) trail->Record(this,val);
+	if ( !observers.empty() ) NotifyRemoved(val);
+}
+/******************************************************************************/
+/*!
+	Put back a value removed by RemoveValue, used by Trail::Undo
+	\param val
+		value to be restored
+*/
+/******************************************************************************/
+INLINE void Variable::RestoreValue(Value val) {
+	domain.Restore(val);
+	if ( !observers.empty() ) NotifyRestored(val);
+}
+/******************************************************************************/
+/*!
+	Tell all observers a value was removed
+*/
+/******************************************************************************/
+INLINE void Variable::NotifyRemoved(Value val) {
+	std::vector< std::pair<Observer*,unsigned> >::const_iterator b = observers.begin();
+	std::vector< std::pair<Observer*,unsigned> >::const_iterator e = observers.end();
+	for ( ; b!=e; ++b ) { b->first->Removed(this,b->second,val); }
+}
+/******************************************************************************/
+/*!
+	Tell all observers a value was restored
+*/
+/******************************************************************************/
+INLINE void Variable::NotifyRestored(Value val) {
+	std::vector< std::pair<Observer*,unsigned> >::const_iterator b = observers.begin();
+	std::vector< std::pair<Observer*,unsigned> >::const_iterator e = observers.end();
+	for ( ; b!=e; ++b ) { b->first->Restored(this,b->second,val); }
+}
+/******************************************************************************/
+/*!
+	Tell all observers the bounds may have changed
+*/
+/******************************************************************************/
+INLINE void Variable::Notify() {
+	std::vector< std::pair<Observer*,unsigned> >::const_iterator b = observers.begin();
+	std::vector< std::pair<Observer*,unsigned> >::const_iterator e = observers.end();
+	for ( ; b!=e; ++b ) { b->first->Changed(this,b->second); }
 }
 /******************************************************************************/
 /*!
@@ -44,7 +83,7 @@ INLINE const std::string & Variable::Name() const {
 */
 /******************************************************************************/
 INLINE int Variable::SizeDomain() const { 
-	return domain.size(); 
+	return domain.Size(); 
 }
 /******************************************************************************/
 /*!
@@ -54,10 +93,19 @@ INLINE int Variable::SizeDomain() const {
 */
 /******************************************************************************/
 INLINE void Variable::SetDomain(const std::set<Value>& vals) { 
-	domain.clear();
-	std::copy(vals.begin(),vals.end(),
-			std::inserter( domain, 
-				domain.begin() ));
+	domain.Assign(vals);
+	if ( !observers.empty() ) Notify();
+}
+/******************************************************************************/
+/*!
+	Set the domain of variable (word-wise copy for bitset domains)
+	\param vals
+		domain previously obtained from GetDomain
+*/
+/******************************************************************************/
+INLINE void Variable::SetDomain(const Domain& vals) { 
+	domain = vals;
+	if ( !observers.empty() ) Notify();
 }
 /******************************************************************************/
 /*!
@@ -67,7 +115,7 @@ INLINE void Variable::SetDomain(const std::set<Value>& vals) {
 		a const reference to a domain
 */
 /******************************************************************************/
-INLINE const std::set<Variable::Value>& Variable::GetDomain() const { 
+INLINE const Variable::Domain& Variable::GetDomain() const { 
 	return domain;
 }
 /******************************************************************************/
@@ -89,7 +137,7 @@ INLINE bool Variable::IsAssigned() const {
 */
 /******************************************************************************/
 INLINE bool Variable::IsImpossible() const { 
-	return domain.size() == 0; 
+	return domain.Empty(); 
 }
 /******************************************************************************/
 /*!
@@ -102,6 +150,64 @@ INLINE unsigned Variable::ID() const {
 	return id; 
 }
 /******************************************************************************/
+/*!
+	Setter for the ID, used by ConstraintGraph to number its variables
+	\param new_id
+		index of the variable in the graph
+*/
+/******************************************************************************/
+INLINE void Variable::SetID(unsigned new_id) { 
+	id = new_id; 
+}
+/******************************************************************************/
+/*!
+	Attach a trail, subsequent removals are logged in it.
+	Note that SetDomain is not logged.
+	\param t
+		trail or NULL to stop logging
+*/
+/******************************************************************************/
+INLINE void Variable::SetTrail(Trail* t) { 
+	trail = t; 
+}
+/******************************************************************************/
+/*!
+	Getter for the attached trail
+	\return 
+		trail or NULL
+*/
+/******************************************************************************/
+INLINE Trail* Variable::GetTrail() const { 
+	return trail; 
+}
+/******************************************************************************/
+/*!
+	Register an object to be notified when the bounds may have changed
+	\param o
+		observer, has to be removed before it is destroyed
+	\param tag
+		passed back to the observer (e.g. position of the variable in 
+		a constraint)
+*/
+/******************************************************************************/
+INLINE void Variable::AddObserver(Variable::Observer* o, unsigned tag) { 
+	observers.push_back( std::make_pair(o,tag) ); 
+}
+/******************************************************************************/
+/*!
+	Unregister an observer (all its tags)
+	\param o
+		observer
+*/
+/******************************************************************************/
+INLINE void Variable::RemoveObserver(Variable::Observer* o) { 
+	std::vector< std::pair<Observer*,unsigned> >::iterator b = observers.begin();
+	while ( b!=observers.end() ) {
+		if ( b->first == o ) b = observers.erase(b);
+		else ++b;
+	}
+}
+/******************************************************************************/
 /*!
 	Assigns a specific value to the variable. Given value should be legal, 
 	that is	be in the domain of this variable, method does not perform 
@@ -112,11 +218,11 @@ INLINE unsigned Variable::ID() const {
 /******************************************************************************/
 INLINE void Variable::Assign(Variable::Value val)  {
 #ifdef DEBUG
-	std::set<Variable::Value>::iterator it = domain.find(val);
 	//check value is in domain
-	if ( it != domain.end() ) {
+	if ( domain.Contains(val) ) {
 		is_assigned = true;
 		assigned_value = val;
+		if ( !observers.empty() ) Notify();
 		return;
 	}
 	throw VariableException("Variable::Assign(Variable::Value) -- value is not in the domain");
@@ -124,6 +230,7 @@ INLINE void Variable::Assign(Variable::Value val)  {
 	is_assigned = true;
 	assigned_value = val;
 #endif
+	if ( !observers.empty() ) Notify();
 }
 /******************************************************************************/
 /*!
@@ -136,7 +243,7 @@ INLINE void Variable::Assign()  {
 	if ( IsImpossible() ) throw VariableException("Variable::Assign() -- empty domain");
 	is_assigned = true;
 	assigned_value = *domain.begin();
-	return;
+	if ( !observers.empty() ) Notify();
 }
 /******************************************************************************/
 /*!
@@ -151,7 +258,7 @@ INLINE void Variable::Assign()  {
 INLINE Variable::Value Variable::GetMinValue() const {
 	if ( is_assigned ) return assigned_value;
 	else if (IsImpossible()) throw VariableException("GetMinValue - empty domain");
-	else return *domain.begin();
+	else return domain.Min();
 		//*std::min_element (domain.begin(),domain.end() );
 }
 /******************************************************************************/
@@ -167,7 +274,7 @@ INLINE Variable::Value Variable::GetMinValue() const {
 INLINE Variable::Value Variable::GetMaxValue() const {
 	if ( is_assigned ) return assigned_value;
 	else if (IsImpossible()) throw VariableException("GetMaxValue - empty domain");
-	else { std::set<Value>::const_iterator it = domain.end(); std::advance(it,-1); return *it; }
+	else return domain.Max();
 		//*std::max_element (domain.begin(),domain.end() );
 }
 /******************************************************************************/
@@ -195,6 +302,7 @@ INLINE void Variable::UnAssign() {
 	if ( !is_assigned ) 
 		throw VariableException("Variable::UnAssign - already unassigned");
 	is_assigned = false; 
+	if ( !observers.empty() ) Notify();
 }
 
 #undef INLINE